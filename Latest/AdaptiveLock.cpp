@@ -0,0 +1,64 @@
+/*
+Copyright (C) 2013 Christopher A. Greeley
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), 
+to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, 
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+#include <ThreadItAtomic.h>
+#ifdef __linux__
+	#include <linux/futex.h>
+	#include <sys/syscall.h>
+	#include <unistd.h>
+	#include <cerrno>
+	#include <ctime>
+#endif
+
+namespace LibThreadIt
+{
+	namespace Implementation
+	{
+		void ParkOnAddress( std::atomic< std::uint32_t >* address, std::uint32_t expected )
+		{
+			#ifdef __linux__
+				syscall( SYS_futex, reinterpret_cast< std::uint32_t* >( address ), 
+						FUTEX_WAIT_PRIVATE, expected, NULL, NULL, 0 );
+			#else
+				//No futex here, give the time slice away and let the caller re - check.//
+				if( address->load( std::memory_order_acquire ) == expected )
+					sched_yield();
+			#endif
+		}
+		bool ParkOnAddressFor( std::atomic< std::uint32_t >* address, std::uint32_t expected, 
+				std::uint64_t timeoutNanoseconds )
+		{
+			#ifdef __linux__
+				//FUTEX_WAIT takes a relative timeout.//
+				timespec timeout;
+				timeout.tv_sec = timeoutNanoseconds / 1000000000ull;
+				timeout.tv_nsec = timeoutNanoseconds % 1000000000ull;
+				if( syscall( SYS_futex, reinterpret_cast< std::uint32_t* >( address ), 
+						FUTEX_WAIT_PRIVATE, expected, &timeout, NULL, 0 ) == -1 )
+					return ( errno != ETIMEDOUT );
+				return ( true );
+			#else
+				if( address->load( std::memory_order_acquire ) == expected )
+					sched_yield();
+				return ( true );
+			#endif
+		}
+		void WakeAddress( std::atomic< std::uint32_t >* address, bool wakeAll )
+		{
+			#ifdef __linux__
+				syscall( SYS_futex, reinterpret_cast< std::uint32_t* >( address ), 
+						FUTEX_WAKE_PRIVATE, ( wakeAll == true ? INT32_MAX : 1 ), NULL, NULL, 0 );
+			#endif
+		}
+	}
+}
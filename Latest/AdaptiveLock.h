@@ -0,0 +1,159 @@
+/*
+Copyright (C) 2013 Christopher A. Greeley
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), 
+to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, 
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+#pragma once
+//Included by ThreadItAtomic.h once the platform is configured.//
+#include <cstdint>
+
+namespace LibThreadIt
+{
+	namespace Implementation
+	{
+		//Tells the core we are spinning so the other hyper - thread gets the pipeline.//
+		inline void CpuRelax()
+		{
+			#if defined( __i386__ ) || defined( __x86_64__ )
+				__builtin_ia32_pause();
+			#elif defined( __aarch64__ ) || defined( __arm__ )
+				__asm__ __volatile__( "yield" );
+			#endif
+		}
+		/*Sleeps in the kernel as long as "address" still holds "expected, " may return 
+		early, callers always re - check.*/
+		void ParkOnAddress( std::atomic< std::uint32_t >* address, std::uint32_t expected );
+		//As ParkOnAddress, but false once "timeoutNanoseconds" have passed.//
+		bool ParkOnAddressFor( std::atomic< std::uint32_t >* address, std::uint32_t expected, 
+				std::uint64_t timeoutNanoseconds );
+		void WakeAddress( std::atomic< std::uint32_t >* address, bool wakeAll );
+	}
+	/*The lock word behind Atomic and AutoAtomic. Spins briefly with exponential 
+	backoff, then parks in the kernel. Unlike a mutex it may be unlocked by a thread 
+	other than the one that locked it, a pool is often aquired on one thread and 
+	released on another. Any number of readers may share it, a writer that is 
+	waiting keeps new readers out so writers are not starved.*/
+	class AdaptiveLock
+	{
+		enum LOCK_STATE {
+			UNLOCKED = 0, 
+			WRITER = 1, 
+			WRITER_WAITING = 2, 
+			//At least one thread may be parked on the word.//
+			PARKED = 4, 
+			//The reader count starts above the flags.//
+			READER = 8
+		};
+		static const std::uint32_t READER_MASK = ~( std::uint32_t )( READER - 1 );
+		//Rounds of backoff before parking, each twice as long as the last.//
+		static const unsigned int BACKOFF_ROUNDS = 7;
+		std::atomic< std::uint32_t > state;
+		//'false' once it is time to park.//
+		static bool Backoff( unsigned int& round )
+		{
+			if( round == BACKOFF_ROUNDS )
+				return ( false );
+			for( unsigned int i = 0; i < ( 1u << round ); ++i )
+				Implementation::CpuRelax();
+			++round;
+			return ( true );
+		}
+		//Marks the word so the next release wakes us, then sleeps until it changes.//
+		void Park( std::uint32_t observed )
+		{
+			if( ( observed & PARKED ) == 0 && state.compare_exchange_strong( observed, 
+					observed | PARKED, std::memory_order_relaxed, std::memory_order_relaxed ) == false )
+				return;
+			Implementation::ParkOnAddress( &state, observed | PARKED );
+		}
+		public: 
+			explicit AdaptiveLock() : state( UNLOCKED ) {
+			}
+			AdaptiveLock( const AdaptiveLock& other ) = delete;
+			AdaptiveLock& operator=( const AdaptiveLock& other ) = delete;
+			void Lock()
+			{
+				unsigned int round = 0;
+				while( true )
+				{
+					std::uint32_t observed = state.load( std::memory_order_relaxed );
+					if( ( observed & ( WRITER | READER_MASK ) ) == 0 )
+					{
+						if( state.compare_exchange_weak( observed, ( observed | WRITER ) & ~WRITER_WAITING, 
+								std::memory_order_acquire, std::memory_order_relaxed ) == true )
+							return;
+						continue;
+					}
+					//Hold new readers back until we are in.//
+					if( ( observed & WRITER_WAITING ) == 0 )
+						state.fetch_or( WRITER_WAITING, std::memory_order_relaxed );
+					if( Backoff( round ) == false )
+						Park( observed | WRITER_WAITING );
+				}
+			}
+			//'true' = did lock, 'false' = did not lock.//
+			bool TryLock()
+			{
+				std::uint32_t observed = state.load( std::memory_order_relaxed );
+				while( ( observed & ( WRITER | READER_MASK ) ) == 0 )
+				{
+					if( state.compare_exchange_weak( observed, ( observed | WRITER ) & ~WRITER_WAITING, 
+							std::memory_order_acquire, std::memory_order_relaxed ) == true )
+						return ( true );
+				}
+				return ( false );
+			}
+			void Unlock()
+			{
+				if( ( state.fetch_and( ~( std::uint32_t )( WRITER | PARKED ), std::memory_order_release ) & PARKED ) != 0 )
+					Implementation::WakeAddress( &state, true );
+			}
+			void LockShared()
+			{
+				unsigned int round = 0;
+				while( true )
+				{
+					std::uint32_t observed = state.load( std::memory_order_relaxed );
+					if( ( observed & ( WRITER | WRITER_WAITING ) ) == 0 )
+					{
+						if( state.compare_exchange_weak( observed, observed + READER, 
+								std::memory_order_acquire, std::memory_order_relaxed ) == true )
+							return;
+						continue;
+					}
+					if( Backoff( round ) == false )
+						Park( observed );
+				}
+			}
+			bool TryLockShared()
+			{
+				std::uint32_t observed = state.load( std::memory_order_relaxed );
+				while( ( observed & ( WRITER | WRITER_WAITING ) ) == 0 )
+				{
+					if( state.compare_exchange_weak( observed, observed + READER, 
+							std::memory_order_acquire, std::memory_order_relaxed ) == true )
+						return ( true );
+				}
+				return ( false );
+			}
+			void UnlockShared()
+			{
+				/*Only the last reader out has anyone to wake. "PARKED" is left for the 
+				writer to clear, clearing it here could hide a thread that parks meanwhile.*/
+				std::uint32_t previous = state.fetch_sub( READER, std::memory_order_release );
+				if( ( previous & READER_MASK ) == READER && ( previous & PARKED ) != 0 )
+					Implementation::WakeAddress( &state, true );
+			}
+			bool IsLocked() {
+				return ( ( state.load( std::memory_order_acquire ) & ( WRITER | READER_MASK ) ) != 0 );
+			}
+	};
+}
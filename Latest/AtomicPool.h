@@ -0,0 +1,136 @@
+/*
+Copyright (C) 2013 Christopher A. Greeley
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), 
+to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, 
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+#pragma once
+#include <array>
+#include <tuple>
+#include <ThreadItAtomic.h>
+
+namespace LibThreadIt
+{
+	/*A fixed set of objects aquired and released together, for when the set is known 
+	at compile time. The pointers are kept in a tuple and the lock words in an array 
+	sorted once at construction, so aquiring is a walk over that array with no heap, 
+	no RTTI and no virtual calls. Lock words come from the LockTable, an AtomicPool 
+	excludes any Atomic or AtomicResource on the same objects and never deadlocks with 
+	them, they aquire in LockKey order too.
+	For example: 
+		AtomicPool< Player, World > pool( &player, &world );
+		auto held = pool.Aquire();
+		held.Get< 0 >().position = held.Get< 1 >().spawnPoint;
+	*/
+	template< typename... ATOMIC_TYPES_T >
+	class AtomicPool
+	{
+		public: 
+			static const std::size_t SIZE = sizeof...( ATOMIC_TYPES_T );
+			static_assert( SIZE > 0, "An AtomicPool needs something to protect." );
+			template< std::size_t INDEX_T >
+			using Element = typename std::tuple_element< INDEX_T, std::tuple< ATOMIC_TYPES_T... > >::type;
+			//Holds the whole pool until it falls from scope.//
+			class Guard
+			{
+				AtomicPool* pool;
+				public: 
+					explicit Guard( AtomicPool& pool_ ) : pool( &pool_ ) {
+						pool->AquireAll();
+					}
+					Guard( Guard&& other ) : pool( other.pool ) {
+						other.pool = nullptr;
+					}
+					Guard( const Guard& other ) = delete;
+					~Guard() {
+						Release();
+					}
+					//Gives the pool back early.//
+					void Release()
+					{
+						if( pool != nullptr ) {
+							pool->ReleaseAll();
+							pool = nullptr;
+						}
+					}
+					template< std::size_t INDEX_T >
+					Element< INDEX_T >& Get() {
+						return *std::get< INDEX_T >( pool->atomicData );
+					}
+			};
+			explicit AtomicPool( ATOMIC_TYPES_T*... atomicData_ ) : atomicData( atomicData_... ), 
+					keys( { { MakeKey( atomicData_ )... } } )
+			{
+				std::sort( keys.begin(), keys.end() );
+				//The same object twice has one lock word, it may only be aquired once.//
+				amountOfLockWords = 0;
+				for( std::size_t i = 0; i < SIZE; ++i )
+					if( amountOfLockWords == 0 || keys[ amountOfLockWords - 1 ] != keys[ i ] )
+						keys[ amountOfLockWords++ ] = keys[ i ];
+				for( std::size_t i = 0; i < amountOfLockWords; ++i )
+					lockWords[ i ].store( Implementation::LockTable::Find( keys[ i ] ), std::memory_order_relaxed );
+			}
+			AtomicPool( const AtomicPool& other ) = delete;
+			Guard Aquire() {
+				return Guard( *this );
+			}
+			void AquireAll()
+			{
+				for( std::size_t i = 0; i < amountOfLockWords; ++i )
+					lockWords[ i ].store( Implementation::LockTable::Lock( 
+							lockWords[ i ].load( std::memory_order_relaxed ), keys[ i ], false ), std::memory_order_relaxed );
+			}
+			//All or nothing, 'true' if the whole pool is held afterwards.//
+			bool TryAquireAll()
+			{
+				for( std::size_t i = 0; i < amountOfLockWords; ++i )
+				{
+					Implementation::LockControlBlock* taken = Implementation::LockTable::TryLock( 
+							lockWords[ i ].load( std::memory_order_relaxed ), keys[ i ], false );
+					if( taken == nullptr )
+					{
+						while( i != 0 )
+							Unlock( --i );
+						return ( false );
+					}
+					lockWords[ i ].store( taken, std::memory_order_relaxed );
+				}
+				return ( true );
+			}
+			void ReleaseAll()
+			{
+				for( std::size_t i = amountOfLockWords; i != 0; --i )
+					Unlock( i - 1 );
+			}
+			//Only while the pool is held.//
+			template< std::size_t INDEX_T >
+			Element< INDEX_T >* Get() {
+				return std::get< INDEX_T >( atomicData );
+			}
+		protected: 
+			template< typename ATOMIC_TYPE_T >
+			static Implementation::LockKey MakeKey( ATOMIC_TYPE_T* atomicData_ )
+			{
+				const Implementation::LockKey KEY = { atomicData_, &typeid( typename std::remove_cv< ATOMIC_TYPE_T >::type ) };
+				return KEY;
+			}
+			//Coroutines parked on the lock word through AquireAsync are handed it here.//
+			void Unlock( std::size_t position ) {
+				Implementation::LockTable::Unlock( lockWords[ position ].load( std::memory_order_relaxed ), false );
+			}
+			std::tuple< ATOMIC_TYPES_T*... > atomicData;
+			//In aquisition order.//
+			std::array< Implementation::LockKey, SIZE > keys;
+			/*Where each lock word was last found, then the one held. Holders and waiters 
+			on other threads may read it meanwhile.*/
+			std::array< std::atomic< Implementation::LockControlBlock* >, SIZE > lockWords;
+			std::size_t amountOfLockWords;
+	};
+}
@@ -14,7 +14,593 @@ WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
 #include <AtomicResource.h>
 namespace LibThreadIt
 {
+	namespace Implementation
+	{
+		/*A hold taken through MacroAtomic::AquireAll. Its manager lists it until it is 
+		released, so a thread that has none of its own can release another thread's. 
+		Whoever takes it off the list releases it, "isReleasedElsewhere" tells the 
+		thread that took it when that was another thread.*/
+		struct AquiredHold
+		{
+			PoolHold hold;
+			//Toward the older holds on the same manager.//
+			AquiredHold* previous;
+			AquiredHold* next;
+			//Only touched under the manager's "aquiredGuard."//
+			bool isListed;
+			std::atomic< bool > isReleasedElsewhere;
+			explicit AquiredHold() : previous( nullptr ), next( nullptr ), isListed( false ), isReleasedElsewhere( false ) {
+			}
+			//Call holding the manager's "aquiredGuard."//
+			void Unlink( AtomicManager* manager )
+			{
+				if( previous != nullptr )
+					previous->next = next;
+				if( next != nullptr )
+					next->previous = previous;
+				else
+					manager->lastAquired = previous;
+				previous = nullptr;
+				next = nullptr;
+				isListed = false;
+			}
+			void List()
+			{
+				AtomicManager* manager = hold.manager;
+				AutoAtomic guard( &manager->aquiredGuard );
+				previous = manager->lastAquired;
+				if( previous != nullptr )
+					previous->next = this;
+				manager->lastAquired = this;
+				isListed = true;
+			}
+			//'false' if another thread took it off first, that thread releases it.//
+			bool Unlist()
+			{
+				AtomicManager* manager = hold.manager;
+				AutoAtomic guard( &manager->aquiredGuard );
+				if( isListed == false )
+					return ( false );
+				Unlink( manager );
+				return ( true );
+			}
+			//Takes the newest hold any thread has on "manager" off the list, null if there is none.//
+			static AquiredHold* UnlistLast( AtomicManager* manager )
+			{
+				AutoAtomic guard( &manager->aquiredGuard );
+				AquiredHold* last = manager->lastAquired;
+				if( last != nullptr )
+					last->Unlink( manager );
+				return last;
+			}
+			//Releases it for the thread that took it, only reading what that thread may read too.//
+			void ReleaseElsewhere() {
+				hold.GiveBack();
+				isReleasedElsewhere.store( true, std::memory_order_release );
+			}
+			//Once released elsewhere, empties it for reuse without unlocking anything again.//
+			void Recycle() {
+				hold.Forget();
+				isReleasedElsewhere.store( false, std::memory_order_relaxed );
+			}
+		};
+		namespace
+		{
+			const std::size_t SHARD_BITS = 4;
+			const std::size_t FIRST_TABLE_CAPACITY = 8;
+			//Tables past this are freed rather than cleared for the next manager.//
+			const std::size_t MAXIMUM_KEPT_TABLE_CAPACITY = 64;
+			const std::size_t MAXIMUM_SPARE_SHARDS = 64;
+			/*Shards of destroyed managers on no particular node, each entry is a whole 
+			set of AtomicManager::AMOUNT_OF_SHARDS. Never freed, managers may be destroyed 
+			during static destruction.*/
+			struct SpareShards
+			{
+				AdaptiveLock guard;
+				std::vector< AtomicShard* > sets;
+			};
+			SpareShards& Spares()
+			{
+				static SpareShards* spares = new SpareShards();
+				return *spares;
+			}
+			//Null if there are none.//
+			AtomicShard* TakeSpareShards()
+			{
+				SpareShards& spares = Spares();
+				AutoAtomic guard( &spares.guard );
+				if( spares.sets.empty() == true )
+					return ( nullptr );
+				AtomicShard* shards = spares.sets.back();
+				spares.sets.pop_back();
+				return shards;
+			}
+			//'false' if there are enough spares already, "shards" is then the caller's to free.//
+			bool KeepSpareShards( AtomicShard* shards )
+			{
+				for( unsigned int i = 0; i < AtomicManager::AMOUNT_OF_SHARDS; ++i )
+					shards[ i ].Clear();
+				SpareShards& spares = Spares();
+				AutoAtomic guard( &spares.guard );
+				if( spares.sets.size() == MAXIMUM_SPARE_SHARDS )
+					return ( false );
+				spares.sets.push_back( shards );
+				return ( true );
+			}
+			std::size_t HashOf( BaseAtomic* atomic ) {
+				return MixHash( AtomicKeyHash()( AtomicKey( atomic->id, atomic->GetAddress() ) ) );
+			}
+			//"table" is not published yet, or "atomic" is new, both are fine to store plainly.//
+			void Place( AtomicTable* table, BaseAtomic* atomic, std::size_t hash )
+			{
+				std::size_t slot = ( hash >> SHARD_BITS ) & table->mask;
+				while( table->slots[ slot ].load( std::memory_order_relaxed ) != nullptr )
+					slot = ( slot + 1 ) & table->mask;
+				table->slots[ slot ].store( atomic, std::memory_order_release );
+			}
+			bool SharesLockWithPrevious( const std::vector< BaseAtomic* >& aquisitionOrder, std::size_t position ) {
+				return ( position != 0 && aquisitionOrder[ position ]->GetLockKey() == 
+						aquisitionOrder[ position - 1 ]->GetLockKey() );
+			}
+			/*Holds taken through MacroAtomic::AquireAll, which has nowhere else to keep them. 
+			The first "amountHeld" are held, the rest were released and are kept, storage 
+			and all, for the next AquireAll. Each on the heap, "coveringHolds" points at them.*/
+			struct ThreadHolds
+			{
+				std::vector< std::unique_ptr< AquiredHold > > holds;
+				std::size_t amountHeld;
+				explicit ThreadHolds() : amountHeld( 0 ) {
+				}
+				//Whatever the thread still holds is given back as it exits.//
+				~ThreadHolds()
+				{
+					for( std::size_t i = amountHeld; i != 0; --i )
+					{
+						AquiredHold& aquired = *holds[ i - 1 ];
+						if( aquired.isReleasedElsewhere.load( std::memory_order_acquire ) == false && 
+								aquired.Unlist() == true ) {
+							aquired.hold.Release();
+							continue;
+						}
+						//Another thread is still reading it.//
+						while( aquired.isReleasedElsewhere.load( std::memory_order_acquire ) == false )
+							std::this_thread::yield();
+						aquired.Recycle();
+					}
+				}
+			};
+			thread_local ThreadHolds threadHolds;
+			//Something running on this thread has "hold, " see HeldOnThisThread.//
+			struct CoveringHold
+			{
+				const PoolHold* hold;
+				//Null unless the hold was taken through AquireAll.//
+				const std::atomic< bool >* isReleasedElsewhere;
+				bool IsOn( const AtomicManager* manager ) const {
+					return ( hold->GetManager() == manager && ( isReleasedElsewhere == nullptr || 
+							isReleasedElsewhere->load( std::memory_order_acquire ) == false ) );
+				}
+			};
+			thread_local std::vector< CoveringHold > coveringHolds;
+			/*Takes a lock word for a hold, counted like an Atomic's own aquire, but 
+			nothing is kept on the atomic, other holds share it. The atomic's lock word 
+			is only read as a hint, it was set when the atomic was branched.*/
+			LockControlBlock* LockForHold( BaseAtomic* atomic, const LockKey& key, ATOMIC_ACCESS access, bool isProfiled )
+			{
+				const bool IS_SHARED = ( access == READ_ACCESS );
+				if( isProfiled == false )
+					return LockTable::Lock( atomic->GetLockBlock(), key, IS_SHARED );
+				std::uint64_t start = ProfilerClock();
+				LockControlBlock* block = LockTable::TryLock( atomic->GetLockBlock(), key, IS_SHARED );
+				bool contended = ( block == nullptr );
+				if( contended == true )
+					block = LockTable::Lock( atomic->GetLockBlock(), key, IS_SHARED );
+				RecordAquire( atomic->GetAddress(), atomic->id.name(), contended, ProfilerClock() - start );
+				return block;
+			}
+			LockControlBlock* TryLockForHold( BaseAtomic* atomic, const LockKey& key, ATOMIC_ACCESS access, bool isProfiled )
+			{
+				LockControlBlock* block = LockTable::TryLock( atomic->GetLockBlock(), key, access == READ_ACCESS );
+				if( block != nullptr && isProfiled == true )
+					RecordAquire( atomic->GetAddress(), atomic->id.name(), false, 0 );
+				return block;
+			}
+			void ForgetHeld( const PoolHold* hold )
+			{
+				for( std::size_t i = coveringHolds.size(); i != 0; --i )
+				{
+					if( coveringHolds[ i - 1 ].hold == hold ) {
+						coveringHolds.erase( coveringHolds.begin() + ( i - 1 ) );
+						return;
+					}
+				}
+			}
+			//Moves the held one at "position" in front of the spares.//
+			void RetireThreadHold( std::size_t position )
+			{
+				std::vector< std::unique_ptr< AquiredHold > >& holds = threadHolds.holds;
+				ForgetHeld( &holds[ position ]->hold );
+				std::rotate( holds.begin() + position, holds.begin() + position + 1, holds.begin() + threadHolds.amountHeld );
+				--threadHolds.amountHeld;
+			}
+			//Retires the holds other threads released for this one, their lock words are given back already.//
+			void RetireReleasedElsewhere()
+			{
+				for( std::size_t i = threadHolds.amountHeld; i != 0; --i )
+				{
+					AquiredHold& aquired = *threadHolds.holds[ i - 1 ];
+					if( aquired.isReleasedElsewhere.load( std::memory_order_acquire ) == true ) {
+						aquired.Recycle();
+						RetireThreadHold( i - 1 );
+					}
+				}
+			}
+			//The next released hold on this thread, one is only made if none is left to reuse.//
+			AquiredHold& SpareThreadHold()
+			{
+				RetireReleasedElsewhere();
+				if( threadHolds.amountHeld == threadHolds.holds.size() )
+					threadHolds.holds.push_back( std::unique_ptr< AquiredHold >( new AquiredHold() ) );
+				return *threadHolds.holds[ threadHolds.amountHeld ];
+			}
+			//Counts the hold SpareThreadHold gave out as held, and lists it with its manager.//
+			void KeepThreadHold()
+			{
+				AquiredHold* aquired = threadHolds.holds[ threadHolds.amountHeld ].get();
+				aquired->List();
+				CoveringHold covering = { &aquired->hold, &aquired->isReleasedElsewhere };
+				coveringHolds.push_back( covering );
+				++threadHolds.amountHeld;
+			}
+		}
+		HeldOnThisThread::HeldOnThisThread( const PoolHold* hold_ ) : hold( hold_ )
+		{
+			if( hold != nullptr ) {
+				CoveringHold covering = { hold, nullptr };
+				coveringHolds.push_back( covering );
+			}
+		}
+		HeldOnThisThread::~HeldOnThisThread()
+		{
+			if( hold != nullptr )
+				ForgetHeld( hold );
+		}
+		bool IsHeldOnThisThread( const AtomicManager* manager )
+		{
+			const std::size_t AMOUNT_OF_HOLDS = coveringHolds.size();
+			for( std::size_t i = 0; i < AMOUNT_OF_HOLDS; ++i )
+				if( coveringHolds[ i ].IsOn( manager ) == true )
+					return ( true );
+			return ( false );
+		}
+		std::uint64_t NextManagerIdentity()
+		{
+			static std::atomic< std::uint64_t > lastIdentity( 0 );
+			return ( lastIdentity.fetch_add( 1, std::memory_order_relaxed ) + 1 );
+		}
+		bool IsCoveredOnThisThread( const AtomicManager* manager, const LockKey& key )
+		{
+			const std::size_t AMOUNT_OF_HOLDS = coveringHolds.size();
+			for( std::size_t i = 0; i < AMOUNT_OF_HOLDS; ++i )
+				if( coveringHolds[ i ].IsOn( manager ) == true && coveringHolds[ i ].hold->Covers( key ) == true )
+					return ( true );
+			return ( false );
+		}
+		AtomicTable::AtomicTable( std::size_t capacity ) : mask( capacity - 1 ), 
+				slots( new std::atomic< BaseAtomic* >[ capacity ] ), replaced( nullptr )
+		{
+			for( std::size_t i = 0; i < capacity; ++i )
+				slots[ i ].store( nullptr, std::memory_order_relaxed );
+		}
+		AtomicTable::~AtomicTable() {
+			delete replaced;
+		}
+		BaseAtomic* AtomicShard::Find( const AtomicKey& key, std::size_t hash )
+		{
+			AtomicTable* current = table.load( std::memory_order_acquire );
+			if( current == nullptr )
+				return ( nullptr );
+			std::size_t slot = ( hash >> SHARD_BITS ) & current->mask;
+			while( true )
+			{
+				BaseAtomic* atomic = current->slots[ slot ].load( std::memory_order_acquire );
+				if( atomic == nullptr )
+					return ( nullptr );
+				if( atomic->id == key.id && atomic->GetAddress() == key.address )
+					return atomic;
+				slot = ( slot + 1 ) & current->mask;
+			}
+		}
+		BaseAtomic* AtomicShard::Insert( std::shared_ptr< BaseAtomic > atomic, std::size_t hash )
+		{
+			AtomicTable* current = table.load( std::memory_order_relaxed );
+			//Grow at half full, before probes get long.//
+			if( current == nullptr || ( amount + 1 ) * 2 > current->mask + 1 )
+			{
+				AtomicTable* grown = new AtomicTable( ( current == nullptr ) ? 
+						FIRST_TABLE_CAPACITY : ( current->mask + 1 ) * 2 );
+				const std::size_t AMOUNT_OF_ATOMICS = atomics.size();
+				for( std::size_t i = 0; i < AMOUNT_OF_ATOMICS; ++i )
+					Place( grown, atomics[ i ].get(), HashOf( atomics[ i ].get() ) );
+				grown->replaced = current;
+				table.store( grown, std::memory_order_release );
+				current = grown;
+			}
+			atomics.push_back( atomic );
+			++amount;
+			Place( current, atomic.get(), hash );
+			return atomic.get();
+		}
+		void AtomicShard::Clear()
+		{
+			AtomicTable* current = table.load( std::memory_order_relaxed );
+			if( current != nullptr && current->mask + 1 > MAXIMUM_KEPT_TABLE_CAPACITY ) {
+				delete current;
+				table.store( nullptr, std::memory_order_relaxed );
+				std::vector< std::shared_ptr< BaseAtomic > >().swap( atomics );
+			}
+			else if( current != nullptr )
+			{
+				delete current->replaced;
+				current->replaced = nullptr;
+				for( std::size_t i = 0; i <= current->mask; ++i )
+					current->slots[ i ].store( nullptr, std::memory_order_relaxed );
+				atomics.clear();
+			}
+			amount = 0;
+		}
+	}
+	AtomicManager::~AtomicManager()
+	{
+		Implementation::AtomicShard* all = shards.load( std::memory_order_acquire );
+		if( all == nullptr )
+			return;
+		if( node < 0 && Implementation::KeepSpareShards( all ) == true )
+			return;
+		for( unsigned int i = 0; i < AMOUNT_OF_SHARDS; ++i )
+			all[ i ].~AtomicShard();
+		Implementation::FreeOnNode( all, AMOUNT_OF_SHARDS * sizeof( Implementation::AtomicShard ), node );
+	}
+	PoolHold::PoolHold( PoolHold&& other ) : manager( other.manager ), taken( std::move( other.taken ) ), 
+			aquiredAt( other.aquiredAt ), order( std::move( other.order ) ), orderOf( other.orderOf ), 
+			orderVersion( other.orderVersion ) {
+		other.manager = nullptr;
+	}
+	PoolHold& PoolHold::operator=( PoolHold&& other )
+	{
+		if( this == &other )
+			return *this;
+		Release();
+		manager = other.manager;
+		taken = std::move( other.taken );
+		aquiredAt = other.aquiredAt;
+		order = std::move( other.order );
+		orderOf = other.orderOf;
+		orderVersion = other.orderVersion;
+		other.manager = nullptr;
+		return *this;
+	}
+	void PoolHold::Release()
+	{
+		if( manager == nullptr )
+			return;
+		GiveBack();
+		Forget();
+	}
+	void PoolHold::GiveBack() const
+	{
+		if( aquiredAt != 0 )
+		{
+			const std::uint64_t HELD_FOR = Implementation::ProfilerClock() - aquiredAt;
+			Implementation::RecordRelease( manager, "AtomicResource", HELD_FOR );
+			const std::size_t AMOUNT_TAKEN = taken.size();
+			for( std::size_t i = 0; i < AMOUNT_TAKEN; ++i )
+				Implementation::RecordRelease( taken[ i ].atomic->GetAddress(), taken[ i ].atomic->id.name(), HELD_FOR );
+		}
+		for( std::size_t i = taken.size(); i != 0; --i )
+			Implementation::LockTable::Unlock( taken[ i - 1 ].block, taken[ i - 1 ].access == READ_ACCESS );
+	}
+	void PoolHold::Forget()
+	{
+		taken.clear();
+		aquiredAt = 0;
+		manager = nullptr;
+	}
+	//"taken" is in LockKey order, the order Hold and TryHold aquire in.//
+	bool PoolHold::Covers( const Implementation::LockKey& key ) const
+	{
+		auto found = std::lower_bound( taken.begin(), taken.end(), key, 
+				[]( const TakenLockWord& left, const Implementation::LockKey& right ) { 
+					return ( left.key < right ); } );
+		return ( found != taken.end() && found->key == key );
+	}
+	PoolHold AtomicManager::Hold()
+	{
+		PoolHold hold;
+		HoldInto( hold );
+		return hold;
+	}
+	bool AtomicManager::TryHold( PoolHold& hold )
+	{
+		hold.Release();
+		return TryHoldInto( hold );
+	}
+	void AtomicManager::AquireAll()
+	{
+		Implementation::AquiredHold& aquired = Implementation::SpareThreadHold();
+		//The thread already holds it, taking the lock words again would wait on ourselves.//
+		if( Implementation::IsHeldOnThisThread( this ) == true )
+			aquired.hold.manager = this;
+		else
+			HoldInto( aquired.hold );
+		Implementation::KeepThreadHold();
+	}
+	bool AtomicManager::TryAquireAll()
+	{
+		Implementation::AquiredHold& aquired = Implementation::SpareThreadHold();
+		if( Implementation::IsHeldOnThisThread( this ) == true )
+			aquired.hold.manager = this;
+		else if( TryHoldInto( aquired.hold ) == false )
+			return ( false );
+		Implementation::KeepThreadHold();
+		return ( true );
+	}
+	/*Gives back the last hold this thread took through AquireAll or TryAquireAll. A 
+	thread without one gives back the last one any thread took, and with none at all 
+	there is nothing to give back.*/
+	void AtomicManager::ReleaseAll()
+	{
+		for( std::size_t i = Implementation::threadHolds.amountHeld; i != 0; --i )
+		{
+			Implementation::AquiredHold& aquired = *Implementation::threadHolds.holds[ i - 1 ];
+			if( aquired.hold.GetManager() != this || aquired.isReleasedElsewhere.load( std::memory_order_acquire ) == true )
+				continue;
+			//Otherwise another thread got to it first and releases it for us.//
+			if( aquired.Unlist() == true ) {
+				aquired.hold.Release();
+				Implementation::RetireThreadHold( i - 1 );
+				return;
+			}
+		}
+		Implementation::AquiredHold* other = Implementation::AquiredHold::UnlistLast( this );
+		if( other != nullptr )
+			other->ReleaseElsewhere();
+	}
+	const AtomicManager::AQUISITION_ORDER* AtomicManager::OrderFor( PoolHold& hold )
+	{
+		const std::uint64_t VERSION = version.load( std::memory_order_acquire );
+		if( hold.orderOf != identity || hold.orderVersion != VERSION ) {
+			hold.order = GetOrder();
+			hold.orderOf = identity;
+			hold.orderVersion = VERSION;
+		}
+		return hold.order.get();
+	}
+	void AtomicManager::HoldInto( PoolHold& hold )
+	{
+		hold.manager = this;
+		const AQUISITION_ORDER* aquisitionOrder = OrderFor( hold );
+		const std::size_t AMOUNT_OF_ATOMICS = ( aquisitionOrder == nullptr ) ? 0 : aquisitionOrder->size();
+		std::uint64_t contentions = 0;
+		std::uint64_t start = 0;
+		const bool IS_PROFILED = ContentionProfiler::IsEnabled();
+		if( IS_PROFILED == true ) {
+			//The pool counts as contended if any of its atomics was.//
+			contentions = Implementation::ThreadContentions();
+			start = Implementation::ProfilerClock();
+		}
+		hold.taken.reserve( AMOUNT_OF_ATOMICS );
+		for( std::size_t i = 0; i < AMOUNT_OF_ATOMICS; ++i )
+		{
+			if( Implementation::SharesLockWithPrevious( *aquisitionOrder, i ) == true )
+				continue;
+			BaseAtomic* atomic = ( *aquisitionOrder )[ i ];
+			PoolHold::TakenLockWord taken = { atomic, atomic->GetLockKey(), nullptr, atomic->accessMode };
+			taken.block = Implementation::LockForHold( atomic, taken.key, taken.access, IS_PROFILED );
+			hold.taken.push_back( taken );
+		}
+		if( IS_PROFILED == true ) {
+			hold.aquiredAt = Implementation::ProfilerClock();
+			Implementation::RecordAquire( this, "AtomicResource", 
+					Implementation::ThreadContentions() != contentions, hold.aquiredAt - start );
+		}
+	}
+	bool AtomicManager::TryHoldInto( PoolHold& hold )
+	{
+		hold.manager = this;
+		const AQUISITION_ORDER* aquisitionOrder = OrderFor( hold );
+		const std::size_t AMOUNT_OF_ATOMICS = ( aquisitionOrder == nullptr ) ? 0 : aquisitionOrder->size();
+		const bool IS_PROFILED = ContentionProfiler::IsEnabled();
+		hold.taken.reserve( AMOUNT_OF_ATOMICS );
+		for( std::size_t i = 0; i < AMOUNT_OF_ATOMICS; ++i )
+		{
+			if( Implementation::SharesLockWithPrevious( *aquisitionOrder, i ) == true )
+				continue;
+			BaseAtomic* atomic = ( *aquisitionOrder )[ i ];
+			PoolHold::TakenLockWord taken = { atomic, atomic->GetLockKey(), nullptr, atomic->accessMode };
+			taken.block = Implementation::TryLockForHold( atomic, taken.key, taken.access, IS_PROFILED );
+			//Back off, giving up only what this call took.//
+			if( taken.block == nullptr ) {
+				hold.Release();
+				return ( false );
+			}
+			hold.taken.push_back( taken );
+		}
+		if( IS_PROFILED == true ) {
+			hold.aquiredAt = Implementation::ProfilerClock();
+			Implementation::RecordAquire( this, "AtomicResource", false, 0 );
+		}
+		return ( true );
+	}
+	std::vector< std::shared_ptr< BaseAtomic > > AtomicManager::GetAtomics()
+	{
+		std::vector< std::shared_ptr< BaseAtomic > > everyAtomic;
+		Implementation::AtomicShard* all = shards.load( std::memory_order_acquire );
+		if( all == nullptr )
+			return everyAtomic;
+		for( unsigned int i = 0; i < AMOUNT_OF_SHARDS; ++i ) {
+			AutoAtomic guard( &all[ i ].guard );
+			everyAtomic.insert( everyAtomic.end(), all[ i ].atomics.begin(), all[ i ].atomics.end() );
+		}
+		return everyAtomic;
+	}
+	Implementation::AtomicShard& AtomicManager::ShardOf( std::size_t hash )
+	{
+		Implementation::AtomicShard* all = shards.load( std::memory_order_acquire );
+		if( all == nullptr )
+		{
+			Implementation::AtomicShard* made = ( node < 0 ) ? Implementation::TakeSpareShards() : nullptr;
+			if( made == nullptr )
+			{
+				void* memory = Implementation::AllocateOnNode( AMOUNT_OF_SHARDS * sizeof( Implementation::AtomicShard ), node );
+				made = static_cast< Implementation::AtomicShard* >( memory );
+				for( unsigned int i = 0; i < AMOUNT_OF_SHARDS; ++i )
+					new( &made[ i ] ) Implementation::AtomicShard();
+			}
+			//Two first Branches may race, one set of shards wins.//
+			if( shards.compare_exchange_strong( all, made, std::memory_order_acq_rel, std::memory_order_acquire ) == false )
+			{
+				if( node < 0 && Implementation::KeepSpareShards( made ) == true )
+					return all[ hash & ( AMOUNT_OF_SHARDS - 1 ) ];
+				for( unsigned int i = 0; i < AMOUNT_OF_SHARDS; ++i )
+					made[ i ].~AtomicShard();
+				Implementation::FreeOnNode( made, AMOUNT_OF_SHARDS * sizeof( Implementation::AtomicShard ), node );
+			}
+			else
+				all = made;
+		}
+		return all[ hash & ( AMOUNT_OF_SHARDS - 1 ) ];
+	}
+	std::shared_ptr< const AtomicManager::AQUISITION_ORDER > AtomicManager::GetOrder()
+	{
+		const std::uint64_t VERSION = version.load( std::memory_order_acquire );
+		if( VERSION == 0 )
+			return ( nullptr );
+		AutoAtomic guard( &orderGuard );
+		if( order != nullptr && orderVersion == VERSION )
+			return order;
+		std::shared_ptr< AQUISITION_ORDER > rebuilt = std::make_shared< AQUISITION_ORDER >();
+		Implementation::AtomicShard* all = shards.load( std::memory_order_acquire );
+		for( unsigned int i = 0; i < AMOUNT_OF_SHARDS; ++i )
+		{
+			AutoAtomic shardGuard( &all[ i ].guard );
+			const std::size_t AMOUNT_OF_ATOMICS = all[ i ].atomics.size();
+			for( std::size_t j = 0; j < AMOUNT_OF_ATOMICS; ++j )
+				rebuilt->push_back( all[ i ].atomics[ j ].get() );
+		}
+		std::sort( rebuilt->begin(), rebuilt->end(), []( BaseAtomic* left, BaseAtomic* right ) { 
+				return ( left->GetLockKey() < right->GetLockKey() ); } );
+		order = rebuilt;
+		orderVersion = VERSION;
+		return order;
+	}
 	std::shared_ptr< LibThreadIt::AtomicManager > MakeAtomicResource() {
-		return std::make_shared< AtomicManager >();
+		return Implementation::MakeRecycled< AtomicManager >();
+	}
+	std::shared_ptr< LibThreadIt::AtomicManager > MakeAtomicResource( int node )
+	{
+		auto manager = std::allocate_shared< AtomicManager >( Implementation::NodeAllocator< AtomicManager >( node ) );
+		manager->SetNode( node );
+		return manager;
 	}
 }
@@ -11,12 +11,16 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, 
 WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 */
+#pragma once
 #include <ThreadItAtomic.h>
 
 namespace LibThreadIt
 {
 	struct MacroAtomic {
 		virtual void AquireAll() = 0;
+		/*All or nothing, 'true' if every atomic is held afterwards, otherwise 
+		nothing this call aquired is kept.*/
+		virtual bool TryAquireAll() = 0;
 		virtual void ReleaseAll() = 0;
 	};
 	/*This structure is nessisary to ensure that uneeded THREAD_HANDLES 
@@ -28,108 +32,425 @@ namespace LibThreadIt
 		}
 		auto handle = ThreadIt( JOIN, SomeFunction, handle );
 	*/
+	namespace Implementation
+	{
+		//What an atomic is looked up by, the same address may be branched as different types.//
+		struct AtomicKey
+		{
+			std::type_index id;
+			const void* address;
+			explicit AtomicKey( std::type_index id_, const void* address_ ) : id( id_ ), address( address_ ) {
+			}
+			bool operator==( const AtomicKey& other ) const {
+				return ( id == other.id && address == other.address );
+			}
+		};
+		struct AtomicKeyHash
+		{
+			std::size_t operator()( const AtomicKey& key ) const {
+				return ( key.id.hash_code() ^ ( reinterpret_cast< std::size_t >( key.address ) * 0x9E3779B97F4A7C15ull ) );
+			}
+		};
+	}
 	struct AtomicResource : public MacroAtomic
 	{
+		explicit AtomicResource() : orderIsStale( false ), indexIsStale( false ), aquiredAt( 0 ), node( -1 ) {
+		}
+		/*Atomics branched from now on are allocated on this node of 
+		NumaTopology::System(), -1 for anywhere. Lock words are spread over every node, 
+		see LockTable.*/
+		void SetNode( int node_ ) {
+			node = node_;
+		}
+		int GetNode() {
+			return node;
+		}
 		template< typename ATOMIC_TYPE_T >
 		Atomic< ATOMIC_TYPE_T > Branch( ATOMIC_TYPE_T* threadSensitiveData )
 		{
-			std::string id = typeid( ATOMIC_TYPE_T* ).name();
-			const unsigned int AMOUNT_OF_ATOMICS = atomics.size();
-			for( unsigned int i = 0; i < AMOUNT_OF_ATOMICS; ++i )
-			{
-				if( atomics[ i ]->id.compare( id ) == 0 )
-				{
-					auto atomicToCopy = reinterpret_cast< 
-							LibThreadIt::Atomic< ATOMIC_TYPE_T >* >( atomics[ i ].get() );
-					if( atomicToCopy->atomicData == threadSensitiveData )
-						return LibThreadIt::Atomic< ATOMIC_TYPE_T >( ( *atomicToCopy ) );
-				}
-			}
-			auto newAtomic = std::make_shared< Atomic< ATOMIC_TYPE_T > >();
-			newAtomic->atomicData = threadSensitiveData;
+			if( indexIsStale == true )
+				RebuildIndex();
+			Implementation::AtomicKey key( typeid( ATOMIC_TYPE_T* ), threadSensitiveData );
+			auto found = index.find( key );
+			if( found != index.end() )
+				return Atomic< ATOMIC_TYPE_T >( *static_cast< Atomic< ATOMIC_TYPE_T >* >( atomics[ found->second ].get() ) );
+			std::shared_ptr< Atomic< ATOMIC_TYPE_T > > newAtomic;
+			if( node < 0 )
+				newAtomic = Implementation::MakeRecycled< Atomic< ATOMIC_TYPE_T > >( threadSensitiveData );
+			else
+				newAtomic = std::allocate_shared< Atomic< ATOMIC_TYPE_T > >( 
+						Implementation::NodeAllocator< Atomic< ATOMIC_TYPE_T > >( node ), threadSensitiveData );
+			index.insert( std::make_pair( key, atomics.size() ) );
 			atomics.push_back( newAtomic );
+			orderIsStale = true;
 			return Atomic< ATOMIC_TYPE_T >( ( *( newAtomic.get() ) ) );
 		}
+		/*Aquires by LockKey rather than insertion order, so two pools that share 
+		atomics can never wait on each other in a cycle.*/
 		virtual void AquireAll()
 		{
-			const unsigned int AMOUNT_OF_ATOMICS = atomics.size();
+			if( orderIsStale == true )
+				RebuildOrder();
+			if( ContentionProfiler::IsEnabled() == false ) {
+				AquireInOrder();
+				return;
+			}
+			//The pool counts as contended if any of its atomics was.//
+			std::uint64_t contentions = Implementation::ThreadContentions();
+			std::uint64_t start = Implementation::ProfilerClock();
+			AquireInOrder();
+			aquiredAt = Implementation::ProfilerClock();
+			Implementation::RecordAquire( this, "AtomicResource", 
+					Implementation::ThreadContentions() != contentions, aquiredAt - start );
+		}
+		virtual bool TryAquireAll()
+		{
+			if( orderIsStale == true )
+				RebuildOrder();
+			const unsigned int AMOUNT_OF_ATOMICS = aquisitionOrder.size();
 			for( unsigned int i = 0; i < AMOUNT_OF_ATOMICS; ++i )
-				atomics[ i ]->AtomicAquire();
+			{
+				if( SharesLockWithPrevious( i ) == true )
+					continue;
+				wasHeld[ i ] = aquisitionOrder[ i ]->IsHeld();
+				if( aquisitionOrder[ i ]->TryAquireForAccess() == false )
+				{
+					//Back off, only give up what this call took.//
+					for( unsigned int j = 0; j < i; ++j )
+						if( SharesLockWithPrevious( j ) == false && wasHeld[ j ] == false )
+							aquisitionOrder[ j ]->Release();
+					return ( false );
+				}
+			}
+			return ( true );
 		}
 		virtual void ReleaseAll()
 		{
+			if( aquiredAt != 0 ) {
+				Implementation::RecordRelease( this, "AtomicResource", Implementation::ProfilerClock() - aquiredAt );
+				aquiredAt = 0;
+			}
 			const unsigned int AMOUNT_OF_ATOMICS = atomics.size();
 			for( unsigned int i = 0; i < AMOUNT_OF_ATOMICS; ++i )
 				atomics[ i ]->Release();
 		}
+		/*Whether AquireAll takes "threadSensitiveData" shared or exclusively, 'false' if 
+		it was never branched from this pool.*/
+		template< typename ATOMIC_TYPE_T >
+		bool SetAccessMode( ATOMIC_TYPE_T* threadSensitiveData, ATOMIC_ACCESS accessMode )
+		{
+			if( indexIsStale == true )
+				RebuildIndex();
+			auto found = index.find( Implementation::AtomicKey( typeid( ATOMIC_TYPE_T* ), threadSensitiveData ) );
+			if( found == index.end() )
+				return ( false );
+			atomics[ found->second ]->accessMode = accessMode;
+			return ( true );
+		}
 		std::vector< std::shared_ptr< BaseAtomic > > GetAtomics() {
 			return atomics;
 		}
 		void SetAtomics( std::vector< std::shared_ptr< BaseAtomic > > atomics_ ) {
 			atomics = atomics_;
+			indexIsStale = true;
+			orderIsStale = true;
 		}
+		//The caller may change the vector, so the index is rebuilt on the next Branch.//
 		std::vector< std::shared_ptr< BaseAtomic > >* ReferenceAtomics() {
+			indexIsStale = true;
+			orderIsStale = true;
 			return &atomics;
 		}
 		protected: 
+			void AquireInOrder()
+			{
+				const unsigned int AMOUNT_OF_ATOMICS = aquisitionOrder.size();
+				for( unsigned int i = 0; i < AMOUNT_OF_ATOMICS; ++i )
+					if( SharesLockWithPrevious( i ) == false )
+						aquisitionOrder[ i ]->AquireForAccess();
+			}
+			void RebuildIndex()
+			{
+				index.clear();
+				const unsigned int AMOUNT_OF_ATOMICS = atomics.size();
+				for( unsigned int i = 0; i < AMOUNT_OF_ATOMICS; ++i )
+					index.insert( std::make_pair( Implementation::AtomicKey( 
+							atomics[ i ]->id, atomics[ i ]->GetAddress() ), i ) );
+				indexIsStale = false;
+			}
+			void RebuildOrder()
+			{
+				aquisitionOrder.clear();
+				const unsigned int AMOUNT_OF_ATOMICS = atomics.size();
+				for( unsigned int i = 0; i < AMOUNT_OF_ATOMICS; ++i )
+					aquisitionOrder.push_back( atomics[ i ].get() );
+				std::sort( aquisitionOrder.begin(), aquisitionOrder.end(), 
+						[]( BaseAtomic* left, BaseAtomic* right ) { 
+							return ( left->GetLockKey() < right->GetLockKey() ); } );
+				wasHeld.assign( AMOUNT_OF_ATOMICS, false );
+				orderIsStale = false;
+			}
+			/*The same object branched with and without const has one lock word, it may 
+			only be aquired once.*/
+			bool SharesLockWithPrevious( unsigned int position ) {
+				return ( position != 0 && aquisitionOrder[ position ]->GetLockKey() == 
+						aquisitionOrder[ position - 1 ]->GetLockKey() );
+			}
 			std::vector< std::shared_ptr< BaseAtomic > > atomics;
+			//Same atomics as above, sorted by LockKey.//
+			std::vector< BaseAtomic* > aquisitionOrder;
+			//Scratch space for TryAquireAll.//
+			std::vector< bool > wasHeld;
+			bool orderIsStale;
+			//Position in "atomics" of each atomic.//
+			std::unordered_map< Implementation::AtomicKey, std::size_t, Implementation::AtomicKeyHash > index;
+			bool indexIsStale;
+			//When the last profiled AquireAll finished, 0 if the profiler was off.//
+			std::uint64_t aquiredAt;
+			int node;
 	};
 	#ifdef THREAD_IT_HAS_CPP_STANDARD_ATOMIC
-		typedef std::atomic< bool > AUTO_ATOMIC_TARGATE;
+		typedef AdaptiveLock AUTO_ATOMIC_TARGATE;
 	#endif
 	struct AutoAtomic
 	{
 		#ifdef THREAD_IT_HAS_CPP_STANDARD_ATOMIC
-			std::atomic< bool >* atomic;
+			AdaptiveLock* atomic;
 		#endif
 		explicit AutoAtomic( AUTO_ATOMIC_TARGATE* targate )
 		{
 			#ifdef THREAD_IT_HAS_CPP_STANDARD_ATOMIC
 				atomic = targate;
-				bool expected = false;
-				while( ( !atomic->compare_exchange_weak( expected, true, 
-						std::memory_order_release, std::memory_order_acquire ) ) )
-					expected = false;
+				atomic->Lock();
 			#endif
 		}
 		~AutoAtomic()
 		{
 			#ifdef THREAD_IT_HAS_CPP_STANDARD_ATOMIC
-				atomic->store( false, std::memory_order_release );
+				atomic->Unlock();
 			#endif
 		}
 	};
+	namespace Implementation
+	{
+		//Spreads the bits of an AtomicKeyHash, the low ones pick the shard.//
+		inline std::size_t MixHash( std::size_t hash )
+		{
+			hash ^= hash >> 33;
+			hash *= 0xFF51AFD7ED558CCDull;
+			hash ^= hash >> 33;
+			return hash;
+		}
+		//Open addressed, slots are only ever filled, never emptied.//
+		struct AtomicTable
+		{
+			std::size_t mask;
+			std::unique_ptr< std::atomic< BaseAtomic* >[] > slots;
+			//Tables this one replaced, a reader may still be probing them.//
+			AtomicTable* replaced;
+			explicit AtomicTable( std::size_t capacity );
+			~AtomicTable();
+		};
+		/*A slice of an AtomicManager. Branch looks atomics up without taking "guard, " 
+		it is only held to add one.*/
+		struct AtomicShard
+		{
+			AdaptiveLock guard;
+			std::atomic< AtomicTable* > table;
+			std::size_t amount;
+			std::vector< std::shared_ptr< BaseAtomic > > atomics;
+			char padding[ CACHE_LINE_SIZE ];
+			explicit AtomicShard() : table( nullptr ), amount( 0 ) {
+			}
+			~AtomicShard() {
+				delete table.load( std::memory_order_relaxed );
+			}
+			BaseAtomic* Find( const AtomicKey& key, std::size_t hash );
+			//Call holding "guard, " after Find came back empty.//
+			BaseAtomic* Insert( std::shared_ptr< BaseAtomic > atomic, std::size_t hash );
+			//Empties it for another manager, its table is kept unless it grew large.//
+			void Clear();
+		};
+	}
+	struct AtomicManager;
+	namespace Implementation {
+		struct AquiredHold;
+	}
+	/*What one aquire of an AtomicManager took, each lock word in the order it was 
+	taken and how. Holding the manager is a property of the hold, not of the manager 
+	or its atomics, so any number of callers may aquire the same manager and each 
+	gives back only what it took. A hold may be released on another thread than the 
+	one that took it. The manager has to outlive its holds.*/
+	class PoolHold
+	{
+		public: 
+			explicit PoolHold() : manager( nullptr ), aquiredAt( 0 ), orderOf( 0 ), orderVersion( 0 ) {
+			}
+			PoolHold( PoolHold&& other );
+			PoolHold& operator=( PoolHold&& other );
+			PoolHold( const PoolHold& other ) = delete;
+			PoolHold& operator=( const PoolHold& other ) = delete;
+			~PoolHold() {
+				Release();
+			}
+			bool IsHeld() const {
+				return ( manager != nullptr );
+			}
+			AtomicManager* GetManager() const {
+				return manager;
+			}
+			//Did this hold take the lock word of "key?"//
+			bool Covers( const Implementation::LockKey& key ) const;
+			//Gives back every lock word, the last taken first.//
+			void Release();
+		protected: 
+			friend struct AtomicManager;
+			friend struct Implementation::AquiredHold;
+			//Unlocks every lock word, but leaves the hold as it is.//
+			void GiveBack() const;
+			//Empties the hold without unlocking anything.//
+			void Forget();
+			struct TakenLockWord
+			{
+				BaseAtomic* atomic;
+				Implementation::LockKey key;
+				Implementation::LockControlBlock* block;
+				ATOMIC_ACCESS access;
+			};
+			AtomicManager* manager;
+			std::vector< TakenLockWord > taken;
+			//When the hold was taken, 0 if the profiler was off.//
+			std::uint64_t aquiredAt;
+			/*The order it was last taken in, kept across releases. Reused while 
+			"orderOf" and "orderVersion" still match the manager's identity and version.*/
+			std::shared_ptr< const std::vector< BaseAtomic* > > order;
+			std::uint64_t orderOf;
+			std::uint64_t orderVersion;
+	};
+	namespace Implementation
+	{
+		/*While one lives, this thread counts as holding "hold's" manager, atomics 
+		branched from it here whose lock words the hold took are covered by it. A null 
+		"hold" does nothing.*/
+		class HeldOnThisThread
+		{
+			const PoolHold* hold;
+			public: 
+				explicit HeldOnThisThread( const PoolHold* hold_ );
+				HeldOnThisThread( const HeldOnThisThread& other ) = delete;
+				~HeldOnThisThread();
+		};
+		bool IsHeldOnThisThread( const AtomicManager* manager );
+		//Never 0 and never handed out twice, so a recycled manager is not mistaken for the one before it.//
+		std::uint64_t NextManagerIdentity();
+		//Does a hold this thread has on "manager" cover the lock word of "key?"//
+		bool IsCoveredOnThisThread( const AtomicManager* manager, const LockKey& key );
+	}
+	/*An AtomicResource many threads may branch from at once. Atomics are spread over 
+	shards by address, finding one that was already branched takes no lock and writes 
+	nothing shared, so Branch scales with the threads calling it. Adding an atomic 
+	locks one shard. Hold works off a snapshot of every atomic in LockKey order, 
+	taken again only after something new was branched. An atomic branched by a thread 
+	that holds the manager is covered by that hold if the hold took its lock word, it 
+	then neither locks nor unlocks. One branched after the hold was taken locks as 
+	usual.*/
 	struct AtomicManager : public MacroAtomic
 	{
-		AtomicResource atomicStorage;
-		AUTO_ATOMIC_TARGATE stateGuard;
+		static const unsigned int AMOUNT_OF_SHARDS = 16;
+		explicit AtomicManager() : shards( nullptr ), identity( Implementation::NextManagerIdentity() ), version( 0 ), 
+				orderVersion( 0 ), lastAquired( nullptr ), node( -1 ) {
+		}
+		AtomicManager( const AtomicManager& other ) = delete;
+		~AtomicManager();
 		template< typename ATOMIC_TYPE_T >
 		Atomic< ATOMIC_TYPE_T > Branch( ATOMIC_TYPE_T* threadSensitiveData )
 		{
-			//Because of the uniform - initialization syntax.//
-			#ifdef THREAD_IT_NACL_PLATFORM
-				AutoAtomic{ &stateGuard };
-			#endif
-			return Atomic< ATOMIC_TYPE_T >( atomicStorage.Branch( threadSensitiveData ) );
+			Implementation::AtomicKey key( typeid( ATOMIC_TYPE_T* ), threadSensitiveData );
+			const std::size_t HASH = Implementation::MixHash( Implementation::AtomicKeyHash()( key ) );
+			Implementation::AtomicShard& shard = ShardOf( HASH );
+			BaseAtomic* found = shard.Find( key, HASH );
+			if( found == nullptr )
+			{
+				AutoAtomic guard( &shard.guard );
+				found = shard.Find( key, HASH );
+				if( found == nullptr ) {
+					std::shared_ptr< BaseAtomic > newAtomic;
+					if( node < 0 )
+						newAtomic = Implementation::MakeRecycled< Atomic< ATOMIC_TYPE_T > >( threadSensitiveData );
+					else
+						newAtomic = std::allocate_shared< Atomic< ATOMIC_TYPE_T > >( 
+								Implementation::NodeAllocator< Atomic< ATOMIC_TYPE_T > >( node ), threadSensitiveData );
+					//Copies start from the lock word the table has for it now.//
+					newAtomic->isBusy = &Implementation::LockTable::Find( newAtomic->GetLockKey() )->lock;
+					found = shard.Insert( newAtomic, HASH );
+					version.fetch_add( 1, std::memory_order_release );
+				}
+			}
+			Atomic< ATOMIC_TYPE_T > branched( *static_cast< Atomic< ATOMIC_TYPE_T >* >( found ) );
+			branched.isCovered = Implementation::IsCoveredOnThisThread( this, branched.GetLockKey() );
+			return branched;
 		}
-		virtual void AquireAll()
+		//Waits for every atomic, in LockKey order, see AtomicResource::AquireAll.//
+		PoolHold Hold();
+		//All or nothing and never waits, 'true' if "hold" holds the manager afterwards.//
+		bool TryHold( PoolHold& hold );
+		/*Keep the hold on the calling thread. ReleaseAll gives back the newest one the 
+		calling thread took, or if it took none the newest one any thread took, so a 
+		manager aquired on one thread can be released on another. Aquiring a manager the 
+		thread already holds only counts one more.*/
+		virtual void AquireAll();
+		virtual bool TryAquireAll();
+		virtual void ReleaseAll();
+		//See AtomicResource::SetAccessMode.//
+		template< typename ATOMIC_TYPE_T >
+		bool SetAccessMode( ATOMIC_TYPE_T* threadSensitiveData, ATOMIC_ACCESS accessMode )
 		{
-			//Because of the uniform - initialization syntax.//
-			#ifdef THREAD_IT_NACL_PLATFORM
-				AutoAtomic{ &stateGuard };
-			#endif
-			atomicStorage.AquireAll();
+			Implementation::AtomicKey key( typeid( ATOMIC_TYPE_T* ), threadSensitiveData );
+			const std::size_t HASH = Implementation::MixHash( Implementation::AtomicKeyHash()( key ) );
+			BaseAtomic* found = ShardOf( HASH ).Find( key, HASH );
+			if( found == nullptr )
+				return ( false );
+			found->accessMode = accessMode;
+			return ( true );
 		}
-		virtual void ReleaseAll()
-		{
-			//Because of the uniform - initialization syntax.//
-			#ifdef THREAD_IT_NACL_PLATFORM
-				AutoAtomic{ &stateGuard };
-			#endif
-			atomicStorage.ReleaseAll();
+		//Call before branching, see AtomicResource::SetNode.//
+		void SetNode( int node_ ) {
+			node = node_;
 		}
+		int GetNode() {
+			return node;
+		}
+		std::vector< std::shared_ptr< BaseAtomic > > GetAtomics();
+		protected: 
+			typedef std::vector< BaseAtomic* > AQUISITION_ORDER;
+			/*The shards are made on the first Branch, plenty of managers never branch. A 
+			manager on no particular node takes the shards of one that was destroyed if 
+			there are any, tables and all, so it does not allocate them again.*/
+			Implementation::AtomicShard& ShardOf( std::size_t hash );
+			//Null if nothing was ever branched.//
+			std::shared_ptr< const AQUISITION_ORDER > GetOrder();
+			//"hold's" cached order if nothing was branched since, the current one otherwise.//
+			const AQUISITION_ORDER* OrderFor( PoolHold& hold );
+			//Takes every lock word into "hold, " which is released, reusing its storage.//
+			void HoldInto( PoolHold& hold );
+			//All or nothing, "hold" is left released if it fails.//
+			bool TryHoldInto( PoolHold& hold );
+			std::atomic< Implementation::AtomicShard* > shards;
+			const std::uint64_t identity;
+			//Moves on with every new atomic.//
+			std::atomic< std::uint64_t > version;
+			AUTO_ATOMIC_TARGATE orderGuard;
+			std::shared_ptr< const AQUISITION_ORDER > order;
+			std::uint64_t orderVersion;
+			friend struct Implementation::AquiredHold;
+			//Every hold taken through AquireAll and not released yet, newest last.//
+			AUTO_ATOMIC_TARGATE aquiredGuard;
+			Implementation::AquiredHold* lastAquired;
+			int node;
 	};
 	std::shared_ptr< LibThreadIt::AtomicManager > MakeAtomicResource();
+	//The manager and its atomics on "node."//
+	std::shared_ptr< LibThreadIt::AtomicManager > MakeAtomicResource( int node );
 }
 #ifdef THREAD_IT_EASY_THREAD
 	typedef std::shared_ptr< LibThreadIt::AtomicManager > ATOMIC_RESOURCE;
@@ -0,0 +1,71 @@
+/*
+Copyright (C) 2013 Christopher A. Greeley
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), 
+to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, 
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+#include <ThreadIt.h>
+
+namespace LibThreadIt
+{
+	#ifdef THREAD_IT_POSIX_PLATFORM
+		namespace Implementation
+		{
+			void BatchGroup::Start( PoolTask* const* tasks_ )
+			{
+				if( amount == 0 ) {
+					//Nothing will ever finish, or take the tree, so finish now.//
+					remaining.store( 1, std::memory_order_relaxed );
+					TaskFinished();
+					return;
+				}
+				tasks = tasks_;
+				if( parent != nullptr && parent->SerializesTree() == true ) {
+					holdsTree = true;
+					if( static_cast< PosixTreeHandle* >( parent.get() )->GetStateGuard()->LockOrQueue( this ) == false )
+						return;
+				}
+				TakeTurn();
+			}
+			void BatchGroup::TakeTurn() {
+				WorkerPool::Global().SubmitBatch( tasks, amount );
+			}
+			void BatchGroup::TaskFinished()
+			{
+				if( remaining.fetch_sub( 1, std::memory_order_acq_rel ) != 1 )
+					return;
+				if( holdsTree == true )
+					static_cast< PosixTreeHandle* >( parent.get() )->GetStateGuard()->UnLock();
+				if( isDone.exchange( TASK_DONE, std::memory_order_acq_rel ) == TASK_JOINED )
+					WakeAddress( &isDone, true );
+				RemoveReference();
+			}
+			void BatchGroup::Wait()
+			{
+				WorkerPool& pool = WorkerPool::Global();
+				while( isDone.load( std::memory_order_acquire ) != TASK_DONE )
+				{
+					if( pool.IsWorkerThread() == true ) {
+						if( pool.RunPendingTask() == false )
+							std::this_thread::yield();
+					}
+					else
+					{
+						//Announce ourselves, so TaskFinished knows to wake us.//
+						std::uint32_t running = TASK_RUNNING;
+						if( isDone.compare_exchange_strong( running, TASK_JOINED, 
+								std::memory_order_relaxed ) == true || running == TASK_JOINED )
+							ParkOnAddress( &isDone, TASK_JOINED );
+					}
+				}
+			}
+		}
+	#endif
+}
@@ -0,0 +1,183 @@
+/*
+Copyright (C) 2013 Christopher A. Greeley
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), 
+to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, 
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+#pragma once
+#include <Task.h>
+#include <iterator>
+
+namespace LibThreadIt
+{
+	#ifdef THREAD_IT_POSIX_PLATFORM
+		struct ThreadHandle;
+		namespace Implementation
+		{
+			/*Everything about a batch that does not depend on the function or the 
+			arguments. The group, the task pointers handed to the pool and the tasks 
+			themselves share one allocation.*/
+			struct BatchGroup : public TreeWaiter
+			{
+				std::atomic< std::size_t > remaining;
+				//TASK_RUNNING, TASK_DONE or TASK_JOINED, as for a ThreadItTask.//
+				std::atomic< std::uint32_t > isDone;
+				//One for each BatchHandle, plus one until the last task finishes.//
+				std::atomic< unsigned int > references;
+				std::size_t amount;
+				//Kept so the tree outlives the batch, and locked for all of it if the tree is serialized.//
+				std::shared_ptr< ThreadHandle > parent;
+				bool holdsTree;
+				//Submitted once the batch has the tree.//
+				PoolTask* const* tasks;
+				void (* destroy )( BatchGroup* );
+				explicit BatchGroup( std::size_t amount_, std::shared_ptr< ThreadHandle > parent_, 
+						void (* destroy_ )( BatchGroup* ) ) : remaining( amount_ ), isDone( TASK_RUNNING ), references( 2 ), 
+						amount( amount_ ), parent( parent_ ), holdsTree( false ), tasks( nullptr ), destroy( destroy_ ) {
+				}
+				/*Submits every task in one go. If the parent serializes the tree and it is 
+				busy, the batch queues for it and is submitted when the tree is handed over, 
+				the caller does not wait.*/
+				void Start( PoolTask* const* tasks_ );
+				virtual void TakeTurn();
+				void TaskFinished();
+				void Wait();
+				void AddReference() {
+					references.fetch_add( 1, std::memory_order_relaxed );
+				}
+				void RemoveReference()
+				{
+					if( references.fetch_sub( 1, std::memory_order_acq_rel ) == 1 )
+						destroy( this );
+				}
+			};
+			template< typename FUNCTION_T, typename ARGUMENT_T >
+			void BatchInvoke( FUNCTION_T& function, ARGUMENT_T& argument ) {
+				function( argument );
+			}
+			template< typename FUNCTION_T, typename... ARGUMENTS_T, std::size_t... INDICES_T >
+			void BatchInvokeTuple( FUNCTION_T& function, std::tuple< ARGUMENTS_T... >& arguments, IndexSequence< INDICES_T... > ) {
+				function( std::get< INDICES_T >( arguments )... );
+			}
+			//A tuple is spread over the parameters.//
+			template< typename FUNCTION_T, typename... ARGUMENTS_T >
+			void BatchInvoke( FUNCTION_T& function, std::tuple< ARGUMENTS_T... >& arguments ) {
+				BatchInvokeTuple( function, arguments, typename MakeIndexSequence< sizeof...( ARGUMENTS_T ) >::Type() );
+			}
+			template< typename FUNCTION_T, typename ARGUMENT_T >
+			struct TypedBatchGroup;
+			template< typename FUNCTION_T, typename ARGUMENT_T >
+			struct BatchTask : public PoolTask
+			{
+				TypedBatchGroup< FUNCTION_T, ARGUMENT_T >* group;
+				ARGUMENT_T argument;
+				template< typename PASSED_T >
+				explicit BatchTask( TypedBatchGroup< FUNCTION_T, ARGUMENT_T >* group_, PASSED_T&& argument_ ) : 
+						group( group_ ), argument( std::forward< PASSED_T >( argument_ ) ) {
+				}
+				virtual void RunOnWorker()
+				{
+					BatchInvoke( group->function, argument );
+					group->TaskFinished();
+				}
+			};
+			template< typename FUNCTION_T, typename ARGUMENT_T >
+			struct TypedBatchGroup : public BatchGroup
+			{
+				typedef BatchTask< FUNCTION_T, ARGUMENT_T > TASK_T;
+				FUNCTION_T function;
+				TASK_T* tasks;
+				static std::size_t AlignUp( std::size_t offset, std::size_t alignment ) {
+					return ( ( offset + alignment - 1 ) / alignment * alignment );
+				}
+				static std::size_t PointersOffset() {
+					return AlignUp( sizeof( TypedBatchGroup ), alignof( PoolTask* ) );
+				}
+				static std::size_t TasksOffset( std::size_t amount ) {
+					return AlignUp( PointersOffset() + amount * sizeof( PoolTask* ), alignof( TASK_T ) );
+				}
+				PoolTask** GetPointers() {
+					return reinterpret_cast< PoolTask** >( reinterpret_cast< char* >( this ) + PointersOffset() );
+				}
+				explicit TypedBatchGroup( std::size_t amount_, std::shared_ptr< ThreadHandle > parent_, FUNCTION_T function_ ) : 
+						BatchGroup( amount_, parent_, &TypedBatchGroup::Destroy ), function( std::move( function_ ) ), 
+						tasks( reinterpret_cast< TASK_T* >( reinterpret_cast< char* >( this ) + TasksOffset( amount_ ) ) ) {
+				}
+				template< typename ITERATOR_T >
+				static TypedBatchGroup* Make( std::size_t amount, std::shared_ptr< ThreadHandle > parent, 
+						FUNCTION_T function, ITERATOR_T first )
+				{
+					static_assert( alignof( TASK_T ) <= alignof( std::max_align_t ) && 
+							alignof( TypedBatchGroup ) <= alignof( std::max_align_t ), 
+							"Batch arguments may not be over aligned." );
+					void* memory = ::operator new( TasksOffset( amount ) + amount * sizeof( TASK_T ) );
+					TypedBatchGroup* group = new( memory ) TypedBatchGroup( amount, parent, std::move( function ) );
+					PoolTask** pointers = group->GetPointers();
+					for( std::size_t i = 0; i < amount; ++i, ++first )
+						pointers[ i ] = new( &group->tasks[ i ] ) TASK_T( group, *first );
+					return group;
+				}
+				static void Destroy( BatchGroup* base )
+				{
+					TypedBatchGroup* group = static_cast< TypedBatchGroup* >( base );
+					for( std::size_t i = 0; i < group->amount; ++i )
+						group->tasks[ i ].~TASK_T();
+					group->~TypedBatchGroup();
+					::operator delete( static_cast< void* >( group ) );
+				}
+			};
+		}
+		/*The one handle for every task of a ThreadItBatch. Copies share the batch, letting 
+		the last copy go does not wait for the tasks, they finish on their own.*/
+		class BatchHandle
+		{
+			Implementation::BatchGroup* group;
+			public: 
+				explicit BatchHandle( Implementation::BatchGroup* group_ ) : group( group_ ) {
+				}
+				BatchHandle( const BatchHandle& other ) : group( other.group ) {
+					group->AddReference();
+				}
+				BatchHandle& operator=( const BatchHandle& other ) = delete;
+				~BatchHandle() {
+					group->RemoveReference();
+				}
+				//Workers help run other tasks while they wait.//
+				void JoinAll() {
+					group->Wait();
+				}
+				bool IsComplete() {
+					return ( group->isDone.load( std::memory_order_acquire ) == Implementation::TASK_DONE );
+				}
+				std::size_t GetSize() {
+					return group->amount;
+				}
+		};
+		/*Runs "function( argument )" on the worker pool for every argument in 
+		[ first, last ), a std::tuple argument is spread over the parameters. The 
+		arguments are copied into the batch, what "function" returns is dropped. "parent" 
+		may be null, if its tree is serialized the whole batch counts as one member of 
+		the tree.*/
+		template< typename FUNCTION_T, typename ITERATOR_T >
+		BatchHandle ThreadItBatch( std::shared_ptr< ThreadHandle > parent, FUNCTION_T function, 
+				ITERATOR_T first, ITERATOR_T last )
+		{
+			typedef typename std::decay< typename std::iterator_traits< ITERATOR_T >::value_type >::type ARGUMENT_T;
+			typedef Implementation::TypedBatchGroup< FUNCTION_T, ARGUMENT_T > GROUP_T;
+			GROUP_T* group = GROUP_T::Make( std::distance( first, last ), parent, std::move( function ), first );
+			group->Start( group->GetPointers() );
+			return BatchHandle( group );
+		}
+		template< typename FUNCTION_T, typename RANGE_T >
+		BatchHandle ThreadItBatch( std::shared_ptr< ThreadHandle > parent, FUNCTION_T function, const RANGE_T& arguments ) {
+			return ThreadItBatch( parent, std::move( function ), std::begin( arguments ), std::end( arguments ) );
+		}
+	#endif
+}
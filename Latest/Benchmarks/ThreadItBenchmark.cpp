@@ -0,0 +1,432 @@
+/*
+Copyright (C) 2013 Christopher A. Greeley
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), 
+to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, 
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+#include <ThreadIt.h>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <string>
+
+/*Micro benchmarks for the hot paths of ThreadIt, build with build_linux.txt. 
+Results are written as JSON to standard out, or to the file named by the first 
+argument, so runs can be kept and compared as the library changes.*/
+namespace
+{
+	typedef std::chrono::steady_clock CLOCK;
+	double NanosecondsSince( CLOCK::time_point start, unsigned long long iterations ) {
+		return std::chrono::duration< double, std::nano >( CLOCK::now() - start ).count() / iterations;
+	}
+	double NanosecondsBetween( CLOCK::time_point start, CLOCK::time_point end ) {
+		return std::chrono::duration< double, std::nano >( end - start ).count();
+	}
+	struct Result
+	{
+		std::string name;
+		//What the benchmark was run over ("pool_size", "threads"), empty if nothing.//
+		std::string parameterName;
+		unsigned long long parameter;
+		//Mean nanoseconds per iteration.//
+		double nanoseconds;
+		unsigned long long iterations;
+	};
+	std::vector< Result > results;
+	void Report( std::string name, std::string parameterName, unsigned long long parameter, 
+			double nanoseconds, unsigned long long iterations )
+	{
+		Result result = { name, parameterName, parameter, nanoseconds, iterations };
+		results.push_back( result );
+		if( parameterName.empty() == true )
+			std::fprintf( stderr, "%s: %.1f ns\n", name.c_str(), nanoseconds );
+		else
+			std::fprintf( stderr, "%s, %s %llu: %.1f ns\n", name.c_str(), parameterName.c_str(), parameter, nanoseconds );
+	}
+	void WriteJson( std::FILE* output )
+	{
+		std::fprintf( output, "{\n\t\"benchmark\": \"ThreadIt\",\n\t\"hardware_threads\": %u,\n\t\"results\": [\n", 
+				std::thread::hardware_concurrency() );
+		const unsigned int AMOUNT_OF_RESULTS = results.size();
+		for( unsigned int i = 0; i < AMOUNT_OF_RESULTS; ++i )
+		{
+			const Result& result = results[ i ];
+			std::fprintf( output, "\t\t{ \"name\": \"%s\", ", result.name.c_str() );
+			if( result.parameterName.empty() == false )
+				std::fprintf( output, "\"%s\": %llu, ", result.parameterName.c_str(), result.parameter );
+			std::fprintf( output, "\"ns_per_op\": %.2f, \"iterations\": %llu }%s\n", 
+					result.nanoseconds, result.iterations, ( i + 1 == AMOUNT_OF_RESULTS ) ? "" : "," );
+		}
+		std::fprintf( output, "\t]\n}\n" );
+	}
+	struct SpawnTimes {
+		CLOCK::time_point ran;
+	};
+	void StampRun( SpawnTimes* times ) {
+		times->ran = CLOCK::now();
+	}
+	/*From the launch call until the procedure starts, and from the procedure 
+	returning until Join returns.*/
+	void BenchmarkSpawn( std::string name, LibThreadIt::THREAD_LAUNCH_MODE launchMode, unsigned long long iterations )
+	{
+		LibThreadIt::ThreadAttributes attributes;
+		attributes.launchMode = launchMode;
+		double spawnTotal = 0, joinTotal = 0;
+		for( unsigned long long i = 0; i < iterations; ++i )
+		{
+			SpawnTimes times;
+			auto start = CLOCK::now();
+			auto handle = LibThreadIt::ThreadItInitialize( attributes, LibThreadIt::DO_NOT_AQUIRE_ALL_ON_START, 
+					LibThreadIt::JOIN, &StampRun, &times );
+			handle->Join();
+			auto joined = CLOCK::now();
+			spawnTotal += NanosecondsBetween( start, times.ran );
+			joinTotal += NanosecondsBetween( times.ran, joined );
+		}
+		Report( name + "_spawn_to_run", "", 0, spawnTotal / iterations, iterations );
+		Report( name + "_join", "", 0, joinTotal / iterations, iterations );
+	}
+	//Children continuing a tree with ThreadIt rather than starting a new one.//
+	void BenchmarkSpawnChild( unsigned long long iterations )
+	{
+		SpawnTimes rootTimes;
+		auto root = LibThreadIt::ThreadItInitialize( LibThreadIt::DO_NOT_AQUIRE_ALL_ON_START, 
+				LibThreadIt::JOIN, &StampRun, &rootTimes );
+		root->Join();
+		auto start = CLOCK::now();
+		for( unsigned long long i = 0; i < iterations; ++i )
+		{
+			SpawnTimes times;
+			LibThreadIt::ThreadIt( LibThreadIt::DO_NOT_AQUIRE_ALL_ON_START, root, 
+					LibThreadIt::JOIN, &StampRun, &times )->Join();
+		}
+		Report( "thread_it_child_round_trip", "", 0, NanosecondsSince( start, iterations ), iterations );
+	}
+	void Nothing( int ) {
+	}
+	//Burns a fixed amount of CPU, the leaves of the tree benchmarks.//
+	double LeafWork( unsigned int leaf )
+	{
+		double total = 0;
+		for( unsigned int i = 0; i < 20000; ++i )
+			total += std::sqrt( double( leaf ) * 20000 + i );
+		return total;
+	}
+	struct TreeJob
+	{
+		LibThreadIt::ThreadAttributes attributes;
+		THREAD_HANDLE root;
+		std::vector< double > sums;
+	};
+	void RunLeaf( TreeJob* job, unsigned int leaf ) {
+		job->sums[ leaf ] = LeafWork( leaf );
+	}
+	//Hands the upper half to a child in the tree and splits the lower half itself.//
+	void Split( TreeJob* job, unsigned int begin, unsigned int end )
+	{
+		if( end - begin == 1 ) {
+			RunLeaf( job, begin );
+			return;
+		}
+		const unsigned int MIDDLE = begin + ( end - begin ) / 2;
+		THREAD_HANDLE upper = LibThreadIt::ThreadIt( job->attributes, LibThreadIt::DO_NOT_AQUIRE_ALL_ON_START, 
+				job->root, LibThreadIt::JOIN, &Split, job, MIDDLE, end );
+		Split( job, begin, MIDDLE );
+		upper->Join();
+	}
+	/*The same leaves on one thread, fanned out into a SERIALIZE_TREE, and split 
+	recursively in a CONCURRENT_TREE, per leaf. A serialized tree runs one leaf at a 
+	time whatever the pool size, it can not split recursively at all since a child 
+	joining its own child would wait for itself. The concurrent tree should approach 
+	the single thread time divided by the amount of workers.*/
+	void BenchmarkTreeDivideAndConquer()
+	{
+		const unsigned int LEAVES = 256;
+		const unsigned long long ROUNDS = 10;
+		TreeJob job;
+		job.sums.assign( LEAVES, 0 );
+		auto start = CLOCK::now();
+		for( unsigned long long i = 0; i < ROUNDS; ++i )
+			for( unsigned int leaf = 0; leaf < LEAVES; ++leaf )
+				RunLeaf( &job, leaf );
+		Report( "tree_leaves_one_thread", "leaves", LEAVES, NanosecondsSince( start, ROUNDS * LEAVES ), ROUNDS * LEAVES );
+		job.attributes.launchMode = LibThreadIt::POOLED_THREAD;
+		for( unsigned int concurrent = 0; concurrent < 2; ++concurrent )
+		{
+			job.attributes.treeBehavior = ( concurrent == 0 ) ? LibThreadIt::SERIALIZE_TREE : LibThreadIt::CONCURRENT_TREE;
+			job.root = LibThreadIt::ThreadItInitialize( job.attributes, LibThreadIt::DO_NOT_AQUIRE_ALL_ON_START, 
+					LibThreadIt::JOIN, &Nothing, 0 );
+			job.root->Join();
+			start = CLOCK::now();
+			for( unsigned long long i = 0; i < ROUNDS; ++i )
+			{
+				if( concurrent == 1 ) {
+					Split( &job, 0, LEAVES );
+					continue;
+				}
+				std::vector< THREAD_HANDLE > leaves;
+				for( unsigned int leaf = 0; leaf < LEAVES; ++leaf )
+					leaves.push_back( LibThreadIt::ThreadIt( job.attributes, LibThreadIt::DO_NOT_AQUIRE_ALL_ON_START, 
+							job.root, LibThreadIt::JOIN, &RunLeaf, &job, leaf ) );
+				for( unsigned int leaf = 0; leaf < LEAVES; ++leaf )
+					leaves[ leaf ]->Join();
+			}
+			Report( ( concurrent == 0 ) ? "serialize_tree_fan_out" : "concurrent_tree_divide_and_conquer", 
+					"leaves", LEAVES, NanosecondsSince( start, ROUNDS * LEAVES ), ROUNDS * LEAVES );
+		}
+	}
+	//ThreadItTask launch and Join, no CallItLater and no handle allocation.//
+	void BenchmarkTask( unsigned long long iterations )
+	{
+		auto start = CLOCK::now();
+		for( unsigned long long i = 0; i < iterations; ++i ) {
+			SpawnTimes times;
+			LibThreadIt::ThreadItTask( &StampRun, &times ).Join();
+		}
+		Report( "task_round_trip", "", 0, NanosecondsSince( start, iterations ), iterations );
+	}
+	//Per task cost of fanning out a ThreadItBatch and joining it.//
+	void BenchmarkBatch()
+	{
+		for( unsigned int batchSize = 16; batchSize <= 16384; batchSize *= 4 )
+		{
+			const unsigned long long ROUNDS = 1000000 / batchSize;
+			std::vector< int > arguments( batchSize );
+			auto start = CLOCK::now();
+			for( unsigned long long i = 0; i < ROUNDS; ++i )
+				LibThreadIt::ThreadItBatch( nullptr, &Nothing, arguments ).JoinAll();
+			Report( "batch_fan_out_per_task", "batch_size", batchSize, 
+					NanosecondsSince( start, ROUNDS * batchSize ), ROUNDS * batchSize );
+		}
+	}
+	//Aquire and release of an Atomic nobody else wants.//
+	void BenchmarkUncontendedAquire()
+	{
+		const unsigned long long ITERATIONS = 5000000;
+		int data = 0;
+		LibThreadIt::Atomic< int > atomic( &data );
+		auto start = CLOCK::now();
+		for( unsigned long long i = 0; i < ITERATIONS; ++i ) {
+			++( *atomic.Aquire() );
+			atomic.Release();
+		}
+		Report( "atomic_aquire_release_uncontended", "", 0, NanosecondsSince( start, ITERATIONS ), ITERATIONS );
+	}
+	//"threads" threads hammering one Atomic, wall time per aquire and release.//
+	void BenchmarkContendedAquire()
+	{
+		const unsigned long long ITERATIONS_PER_THREAD = 200000;
+		for( unsigned int threads = 2; threads <= 8; threads *= 2 )
+		{
+			int data = 0;
+			std::vector< std::thread > contenders;
+			auto start = CLOCK::now();
+			for( unsigned int i = 0; i < threads; ++i )
+			{
+				contenders.push_back( std::thread( [ &data, ITERATIONS_PER_THREAD ]() {
+						LibThreadIt::Atomic< int > atomic( &data );
+						for( unsigned long long j = 0; j < ITERATIONS_PER_THREAD; ++j ) {
+							++( *atomic.Aquire() );
+							atomic.Release();
+						}
+					} ) );
+			}
+			for( unsigned int i = 0; i < threads; ++i )
+				contenders[ i ].join();
+			Report( "atomic_aquire_release_contended", "threads", threads, 
+					NanosecondsSince( start, ITERATIONS_PER_THREAD * threads ), ITERATIONS_PER_THREAD * threads );
+		}
+	}
+	//Readers of a VersionedAtomic against the same readers taking an Atomic shared, per read.//
+	void BenchmarkReadScaling()
+	{
+		const unsigned long long READS_PER_THREAD = 1000000;
+		struct Transform {
+			double x, y, z, w;
+		};
+		for( unsigned int threads = 1; threads <= 8; threads *= 2 )
+		{
+			LibThreadIt::VersionedAtomic< Transform > versioned;
+			Transform shared = Transform();
+			std::vector< std::thread > readers;
+			auto start = CLOCK::now();
+			for( unsigned int i = 0; i < threads; ++i )
+			{
+				readers.push_back( std::thread( [ &versioned, READS_PER_THREAD ]() {
+						double total = 0;
+						for( unsigned long long j = 0; j < READS_PER_THREAD; ++j )
+							total += versioned.Load().x;
+						( void ) total;
+					} ) );
+			}
+			for( unsigned int i = 0; i < threads; ++i )
+				readers[ i ].join();
+			Report( "versioned_atomic_load", "threads", threads, 
+					NanosecondsSince( start, READS_PER_THREAD * threads ), READS_PER_THREAD * threads );
+			readers.clear();
+			start = CLOCK::now();
+			for( unsigned int i = 0; i < threads; ++i )
+			{
+				readers.push_back( std::thread( [ &shared, READS_PER_THREAD ]() {
+						LibThreadIt::Atomic< Transform > atomic( &shared );
+						double total = 0;
+						for( unsigned long long j = 0; j < READS_PER_THREAD; ++j ) {
+							total += atomic.Read()->x;
+							atomic.Release();
+						}
+						( void ) total;
+					} ) );
+			}
+			for( unsigned int i = 0; i < threads; ++i )
+				readers[ i ].join();
+			Report( "atomic_read_shared", "threads", threads, 
+					NanosecondsSince( start, READS_PER_THREAD * threads ), READS_PER_THREAD * threads );
+		}
+	}
+	//Scheduling and cancelling with this many timers already pending, per timer.//
+	void BenchmarkTimers()
+	{
+		const unsigned long long TIMERS = 50000;
+		std::vector< LibThreadIt::TimerHandle > timers;
+		timers.reserve( TIMERS );
+		auto start = CLOCK::now();
+		for( unsigned long long i = 0; i < TIMERS; ++i )
+			timers.push_back( LibThreadIt::ThreadItAfter( std::chrono::milliseconds( 1000 + i % 60000 ), Nothing, 0 ) );
+		Report( "timer_schedule", "pending", TIMERS, NanosecondsSince( start, TIMERS ), TIMERS );
+		start = CLOCK::now();
+		for( unsigned long long i = 0; i < TIMERS; ++i )
+			timers[ i ].Cancel();
+		Report( "timer_cancel", "pending", TIMERS, NanosecondsSince( start, TIMERS ), TIMERS );
+	}
+	//Cost of looking up an atomic that is already in the pool, as the pool grows.//
+	void BenchmarkBranch()
+	{
+		const unsigned long long LOOKUPS = 1000000;
+		for( unsigned int poolSize = 16; poolSize <= 16384; poolSize *= 4 )
+		{
+			std::vector< int > data( poolSize );
+			LibThreadIt::AtomicResource pool;
+			for( unsigned int i = 0; i < poolSize; ++i )
+				pool.Branch( &data[ i ] );
+			//Stride through the pool so consecutive lookups do not hit the same entry.//
+			unsigned int next = 0;
+			auto start = CLOCK::now();
+			for( unsigned long long i = 0; i < LOOKUPS; ++i ) {
+				auto atomic = pool.Branch( &data[ next ] );
+				next = ( next + 7919 ) % poolSize;
+			}
+			Report( "atomic_resource_branch", "pool_size", poolSize, NanosecondsSince( start, LOOKUPS ), LOOKUPS );
+		}
+	}
+	//Threads branching from one shared AtomicManager at once, per Branch.//
+	void BenchmarkSharedBranch()
+	{
+		const unsigned long long LOOKUPS_PER_THREAD = 500000;
+		const unsigned int POOL_SIZE = 1024;
+		std::vector< int > data( POOL_SIZE );
+		auto manager = LibThreadIt::MakeAtomicResource();
+		for( unsigned int i = 0; i < POOL_SIZE; ++i )
+			manager->Branch( &data[ i ] );
+		for( unsigned int threads = 1; threads <= 8; threads *= 2 )
+		{
+			std::vector< std::thread > branchers;
+			auto start = CLOCK::now();
+			for( unsigned int i = 0; i < threads; ++i )
+			{
+				branchers.push_back( std::thread( [ &manager, &data, i, LOOKUPS_PER_THREAD, POOL_SIZE ]() {
+						unsigned int next = i;
+						for( unsigned long long j = 0; j < LOOKUPS_PER_THREAD; ++j ) {
+							auto atomic = manager->Branch( &data[ next ] );
+							next = ( next + 7919 ) % POOL_SIZE;
+						}
+					} ) );
+			}
+			for( unsigned int i = 0; i < threads; ++i )
+				branchers[ i ].join();
+			Report( "atomic_manager_branch_shared", "threads", threads, 
+					NanosecondsSince( start, LOOKUPS_PER_THREAD * threads ), LOOKUPS_PER_THREAD * threads );
+		}
+	}
+	//One AquireAll and ReleaseAll of the whole pool.//
+	void BenchmarkAquireAll()
+	{
+		for( unsigned int poolSize = 16; poolSize <= 16384; poolSize *= 4 )
+		{
+			const unsigned long long ROUNDS = 4000000 / poolSize;
+			std::vector< int > data( poolSize );
+			LibThreadIt::AtomicResource pool;
+			for( unsigned int i = 0; i < poolSize; ++i )
+				pool.Branch( &data[ i ] );
+			auto start = CLOCK::now();
+			for( unsigned long long i = 0; i < ROUNDS; ++i ) {
+				pool.AquireAll();
+				pool.ReleaseAll();
+			}
+			Report( "atomic_resource_aquire_release_all", "pool_size", poolSize, NanosecondsSince( start, ROUNDS ), ROUNDS );
+		}
+	}
+	//The same four objects through an AtomicPool and through an AtomicResource.//
+	void BenchmarkAtomicPool()
+	{
+		const unsigned long long ROUNDS = 1000000;
+		struct Body {
+			double x, y;
+		};
+		int count = 0;
+		double mass = 0;
+		Body body = Body();
+		std::string name;
+		LibThreadIt::AtomicPool< int, double, Body, std::string > pool( &count, &mass, &body, &name );
+		auto start = CLOCK::now();
+		for( unsigned long long i = 0; i < ROUNDS; ++i ) {
+			auto held = pool.Aquire();
+			++held.Get< 0 >();
+		}
+		Report( "atomic_pool_aquire_release_all", "pool_size", 4, NanosecondsSince( start, ROUNDS ), ROUNDS );
+		LibThreadIt::AtomicResource resource;
+		resource.Branch( &count );
+		resource.Branch( &mass );
+		resource.Branch( &body );
+		resource.Branch( &name );
+		start = CLOCK::now();
+		for( unsigned long long i = 0; i < ROUNDS; ++i ) {
+			resource.AquireAll();
+			++count;
+			resource.ReleaseAll();
+		}
+		Report( "atomic_resource_aquire_release_all", "pool_size", 4, NanosecondsSince( start, ROUNDS ), ROUNDS );
+	}
+}
+int main( int argc, char** argv )
+{
+	BenchmarkSpawn( "os_thread", LibThreadIt::OS_THREAD, 2000 );
+	BenchmarkSpawn( "pooled_thread", LibThreadIt::POOLED_THREAD, 20000 );
+	BenchmarkSpawnChild( 2000 );
+	BenchmarkTreeDivideAndConquer();
+	BenchmarkTask( 20000 );
+	BenchmarkBatch();
+	BenchmarkUncontendedAquire();
+	BenchmarkContendedAquire();
+	BenchmarkReadScaling();
+	BenchmarkTimers();
+	BenchmarkBranch();
+	BenchmarkSharedBranch();
+	BenchmarkAquireAll();
+	BenchmarkAtomicPool();
+	std::FILE* output = stdout;
+	if( argc > 1 && ( output = std::fopen( argv[ 1 ], "w" ) ) == nullptr ) {
+		std::fprintf( stderr, "Could not open %s\n", argv[ 1 ] );
+		return 1;
+	}
+	WriteJson( output );
+	if( output != stdout )
+		std::fclose( output );
+	return 0;
+}
@@ -0,0 +1,246 @@
+/*
+Copyright (C) 2013 Christopher A. Greeley
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), 
+to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, 
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+#pragma once
+#include <ThreadItAtomic.h>
+#include <type_traits>
+
+namespace LibThreadIt
+{
+	/*A bounded queue any number of threads may push to and pop from without a lock, 
+	after Dmitry Vyukov's bounded MPMC queue. Every cell carries a sequence number 
+	saying whose turn it is, so producers and consumers only contend on the position 
+	they claim. The batched calls claim a run of cells with one compare and swap. 
+	Blocking calls park on a futex, and only when the channel is full (or empty).*/
+	template< typename ELEMENT_T >
+	class Channel
+	{
+		struct Cell
+		{
+			std::atomic< std::size_t > sequence;
+			typename std::aligned_storage< sizeof( ELEMENT_T ), alignof( ELEMENT_T ) >::type storage;
+			ELEMENT_T* Get() {
+				return reinterpret_cast< ELEMENT_T* >( &storage );
+			}
+		};
+		Cell* cells;
+		std::size_t mask;
+		char padding0[ Implementation::CACHE_LINE_SIZE ];
+		std::atomic< std::size_t > enqueuePosition;
+		char padding1[ Implementation::CACHE_LINE_SIZE ];
+		std::atomic< std::size_t > dequeuePosition;
+		char padding2[ Implementation::CACHE_LINE_SIZE ];
+		/*Bumped when a pop makes room or a push brings data, but only while someone 
+		is parked on them, so the fast path never writes these lines.*/
+		std::atomic< std::uint32_t > spaceSignal;
+		std::atomic< std::uint32_t > waitingPushers;
+		std::atomic< std::uint32_t > dataSignal;
+		std::atomic< std::uint32_t > waitingPoppers;
+		std::atomic< bool > isClosed;
+		/*How many cells from "position" on are ready for us, producers want cells 
+		whose sequence is their position, consumers want position + 1. -1 means 
+		someone else took "position" first.*/
+		std::ptrdiff_t CountReady( std::size_t position, std::size_t offset, std::size_t most )
+		{
+			std::size_t ready = 0;
+			for( ; ready < most; ++ready )
+			{
+				Cell& cell = cells[ ( position + ready ) & mask ];
+				std::ptrdiff_t difference = ( std::ptrdiff_t ) cell.sequence.load( std::memory_order_acquire ) - 
+						( std::ptrdiff_t )( position + ready + offset );
+				if( difference < 0 )
+					break;
+				if( difference > 0 )
+					return ( ( ready == 0 ) ? -1 : ready );
+			}
+			return ready;
+		}
+		//Claims up to "most" consecutive cells, returns how many and where they start.//
+		std::size_t Claim( std::atomic< std::size_t >& position, std::size_t offset, 
+				std::size_t most, std::size_t& first )
+		{
+			first = position.load( std::memory_order_relaxed );
+			while( true )
+			{
+				std::ptrdiff_t ready = CountReady( first, offset, most );
+				if( ready == 0 )
+					return 0;
+				if( ready < 0 ) {
+					first = position.load( std::memory_order_relaxed );
+					continue;
+				}
+				if( position.compare_exchange_weak( first, first + ready, 
+						std::memory_order_relaxed, std::memory_order_relaxed ) == true )
+					return ready;
+			}
+		}
+		static void Signal( std::atomic< std::uint32_t >& signal, std::atomic< std::uint32_t >& waiting )
+		{
+			//Pairs with the fence in Wait, either we see the waiter or it sees our change.//
+			std::atomic_thread_fence( std::memory_order_seq_cst );
+			if( waiting.load( std::memory_order_relaxed ) == 0 )
+				return;
+			signal.fetch_add( 1, std::memory_order_release );
+			Implementation::WakeAddress( &signal, true );
+		}
+		/*Parks until "signal" moves, unless "isReady" already holds once we are counted 
+		as waiting, or the channel is closed.*/
+		template< typename READY_T >
+		void Wait( std::atomic< std::uint32_t >& signal, std::atomic< std::uint32_t >& waiting, READY_T isReady )
+		{
+			std::uint32_t observed = signal.load( std::memory_order_acquire );
+			waiting.fetch_add( 1, std::memory_order_relaxed );
+			std::atomic_thread_fence( std::memory_order_seq_cst );
+			if( isReady() == false && isClosed.load( std::memory_order_acquire ) == false )
+				Implementation::ParkOnAddress( &signal, observed );
+			waiting.fetch_sub( 1, std::memory_order_relaxed );
+		}
+		bool HasSpace() {
+			return ( CountReady( enqueuePosition.load( std::memory_order_relaxed ), 0, 1 ) != 0 );
+		}
+		bool HasData() {
+			return ( CountReady( dequeuePosition.load( std::memory_order_relaxed ), 1, 1 ) != 0 );
+		}
+		public: 
+			//"capacity" is rounded up to a power of two.//
+			explicit Channel( std::size_t capacity ) : spaceSignal( 0 ), waitingPushers( 0 ), 
+					dataSignal( 0 ), waitingPoppers( 0 ), isClosed( false )
+			{
+				std::size_t size = 2;
+				while( size < capacity )
+					size *= 2;
+				cells = new Cell[ size ];
+				mask = size - 1;
+				for( std::size_t i = 0; i < size; ++i )
+					cells[ i ].sequence.store( i, std::memory_order_relaxed );
+				enqueuePosition.store( 0, std::memory_order_relaxed );
+				dequeuePosition.store( 0, std::memory_order_relaxed );
+			}
+			Channel( const Channel& other ) = delete;
+			Channel& operator=( const Channel& other ) = delete;
+			~Channel()
+			{
+				std::size_t end = enqueuePosition.load( std::memory_order_relaxed );
+				for( std::size_t i = dequeuePosition.load( std::memory_order_relaxed ); i != end; ++i )
+					cells[ i & mask ].Get()->~ELEMENT_T();
+				delete[] cells;
+			}
+			std::size_t GetCapacity() {
+				return mask + 1;
+			}
+			//'false' if the channel is full or closed.//
+			bool TryPush( ELEMENT_T value ) {
+				return ( TryPushN( &value, 1 ) == 1 );
+			}
+			//Waits for room, 'false' if the channel is closed.//
+			bool Push( ELEMENT_T value ) {
+				return ( PushN( &value, 1 ) == 1 );
+			}
+			//'false' if the channel is empty.//
+			bool TryPop( ELEMENT_T& value ) {
+				return ( TryPopN( &value, 1 ) == 1 );
+			}
+			//Waits for data, 'false' once the channel is closed and drained.//
+			bool Pop( ELEMENT_T& value ) {
+				return ( PopN( &value, 1 ) == 1 );
+			}
+			//Moves as many of "values" in as there is room for, returns how many.//
+			std::size_t TryPushN( ELEMENT_T* values, std::size_t amount )
+			{
+				if( amount == 0 || isClosed.load( std::memory_order_relaxed ) == true )
+					return 0;
+				std::size_t first;
+				std::size_t claimed = Claim( enqueuePosition, 0, amount, first );
+				for( std::size_t i = 0; i < claimed; ++i )
+				{
+					Cell& cell = cells[ ( first + i ) & mask ];
+					new( &cell.storage ) ELEMENT_T( std::move( values[ i ] ) );
+					cell.sequence.store( first + i + 1, std::memory_order_release );
+				}
+				if( claimed != 0 )
+					Signal( dataSignal, waitingPoppers );
+				return claimed;
+			}
+			//Waits until all of "values" are in, returns fewer if the channel is closed.//
+			std::size_t PushN( ELEMENT_T* values, std::size_t amount )
+			{
+				std::size_t pushed = 0;
+				while( pushed < amount && isClosed.load( std::memory_order_relaxed ) == false )
+				{
+					pushed += TryPushN( values + pushed, amount - pushed );
+					if( pushed < amount )
+						Wait( spaceSignal, waitingPushers, [ this ]() { return HasSpace(); } );
+				}
+				return pushed;
+			}
+			//Moves up to "amount" elements out, returns how many.//
+			std::size_t TryPopN( ELEMENT_T* values, std::size_t amount )
+			{
+				if( amount == 0 )
+					return 0;
+				std::size_t first;
+				std::size_t claimed = Claim( dequeuePosition, 1, amount, first );
+				for( std::size_t i = 0; i < claimed; ++i )
+				{
+					Cell& cell = cells[ ( first + i ) & mask ];
+					values[ i ] = std::move( *cell.Get() );
+					cell.Get()->~ELEMENT_T();
+					cell.sequence.store( first + i + mask + 1, std::memory_order_release );
+				}
+				if( claimed != 0 )
+					Signal( spaceSignal, waitingPushers );
+				return claimed;
+			}
+			/*Waits for at least one element, then takes up to "amount" of what is there. 
+			0 once the channel is closed and drained.*/
+			std::size_t PopN( ELEMENT_T* values, std::size_t amount )
+			{
+				if( amount == 0 )
+					return 0;
+				while( true )
+				{
+					std::size_t popped = TryPopN( values, amount );
+					if( popped != 0 )
+						return popped;
+					if( isClosed.load( std::memory_order_acquire ) == true )
+					{
+						//Anything pushed before the close is still ours, a push may have claimed a cell and not filled it yet.//
+						if( dequeuePosition.load( std::memory_order_acquire ) == enqueuePosition.load( std::memory_order_acquire ) )
+							return 0;
+						std::this_thread::yield();
+						continue;
+					}
+					Wait( dataSignal, waitingPoppers, [ this ]() { return HasData(); } );
+				}
+			}
+			/*No more pushes succeed, pops drain what is left and then fail. Everyone 
+			parked on the channel is woken.*/
+			void Close()
+			{
+				isClosed.store( true, std::memory_order_release );
+				std::atomic_thread_fence( std::memory_order_seq_cst );
+				spaceSignal.fetch_add( 1, std::memory_order_release );
+				dataSignal.fetch_add( 1, std::memory_order_release );
+				Implementation::WakeAddress( &spaceSignal, true );
+				Implementation::WakeAddress( &dataSignal, true );
+			}
+			bool IsClosed() {
+				return isClosed.load( std::memory_order_acquire );
+			}
+	};
+	//For passing a channel to the threads on both ends of it.//
+	template< typename ELEMENT_T >
+	std::shared_ptr< Channel< ELEMENT_T > > MakeChannel( std::size_t capacity ) {
+		return std::make_shared< Channel< ELEMENT_T > >( capacity );
+	}
+}
@@ -0,0 +1,252 @@
+/*
+Copyright (C) 2013 Christopher A. Greeley
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), 
+to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, 
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+#include <AtomicResource.h>
+#include <algorithm>
+#include <memory>
+#include <unordered_map>
+
+namespace LibThreadIt
+{
+	std::atomic< bool > ContentionProfiler::enabled( false );
+	namespace Implementation
+	{
+		namespace
+		{
+			//Written only by the owning thread, read by snapshots on any thread.//
+			struct ProfileSlot
+			{
+				std::atomic< const void* > address;
+				std::atomic< const char* > typeName;
+				std::atomic< std::uint64_t > aquires;
+				std::atomic< std::uint64_t > contendedAquires;
+				std::atomic< std::uint64_t > totalWaitNanoseconds;
+				std::atomic< std::uint64_t > maximumWaitNanoseconds;
+				std::atomic< std::uint64_t > totalHoldNanoseconds;
+			};
+			typedef std::unique_ptr< ProfileSlot[] > PROFILE_SLOTS;
+			//Live tables, and what threads that have exited left behind.//
+			struct ProfileRegistry;
+			ProfileRegistry& Registry();
+			std::mutex& RegistryGuard( ProfileRegistry& registry );
+			/*Open addressing. Only the owner writes and snapshots read under the registry 
+			lock, so the owner grows the table under that lock and can drop the old one 
+			straight away. Kept at most half full.*/
+			struct ThreadProfile
+			{
+				static const unsigned int INITIAL_AMOUNT_OF_SLOTS = 256;
+				PROFILE_SLOTS slots;
+				unsigned int amountOfSlots;
+				unsigned int amountUsed;
+				std::uint64_t contentions;
+				explicit ThreadProfile() : amountOfSlots( INITIAL_AMOUNT_OF_SLOTS ), amountUsed( 0 ), contentions( 0 ) {
+					slots = MakeSlots( amountOfSlots );
+				}
+				static PROFILE_SLOTS MakeSlots( unsigned int amount )
+				{
+					PROFILE_SLOTS made( new ProfileSlot[ amount ] );
+					for( unsigned int i = 0; i < amount; ++i )
+						Clear( made[ i ] );
+					return made;
+				}
+				static void Clear( ProfileSlot& slot )
+				{
+					slot.address.store( nullptr, std::memory_order_relaxed );
+					slot.typeName.store( nullptr, std::memory_order_relaxed );
+					slot.aquires.store( 0, std::memory_order_relaxed );
+					slot.contendedAquires.store( 0, std::memory_order_relaxed );
+					slot.totalWaitNanoseconds.store( 0, std::memory_order_relaxed );
+					slot.maximumWaitNanoseconds.store( 0, std::memory_order_relaxed );
+					slot.totalHoldNanoseconds.store( 0, std::memory_order_relaxed );
+				}
+				static void Copy( ProfileSlot& to, const ProfileSlot& from )
+				{
+					to.typeName.store( from.typeName.load( std::memory_order_relaxed ), std::memory_order_relaxed );
+					to.aquires.store( from.aquires.load( std::memory_order_relaxed ), std::memory_order_relaxed );
+					to.contendedAquires.store( from.contendedAquires.load( std::memory_order_relaxed ), std::memory_order_relaxed );
+					to.totalWaitNanoseconds.store( from.totalWaitNanoseconds.load( std::memory_order_relaxed ), std::memory_order_relaxed );
+					to.maximumWaitNanoseconds.store( from.maximumWaitNanoseconds.load( std::memory_order_relaxed ), std::memory_order_relaxed );
+					to.totalHoldNanoseconds.store( from.totalHoldNanoseconds.load( std::memory_order_relaxed ), std::memory_order_relaxed );
+					to.address.store( from.address.load( std::memory_order_relaxed ), std::memory_order_relaxed );
+				}
+				static std::size_t HashOf( const void* address )
+				{
+					std::size_t hash = reinterpret_cast< std::size_t >( address ) >> 4;
+					return ( hash ^ ( hash >> 9 ) );
+				}
+				static ProfileSlot& Probe( ProfileSlot* table, unsigned int amount, const void* address )
+				{
+					std::size_t at = HashOf( address ) & ( amount - 1 );
+					while( true )
+					{
+						const void* found = table[ at ].address.load( std::memory_order_relaxed );
+						if( found == address || found == nullptr )
+							return table[ at ];
+						at = ( at + 1 ) & ( amount - 1 );
+					}
+				}
+				void Grow()
+				{
+					const unsigned int GROWN_AMOUNT = amountOfSlots * 2;
+					PROFILE_SLOTS grown = MakeSlots( GROWN_AMOUNT );
+					for( unsigned int i = 0; i < amountOfSlots; ++i )
+					{
+						const void* address = slots[ i ].address.load( std::memory_order_relaxed );
+						if( address != nullptr )
+							Copy( Probe( grown.get(), GROWN_AMOUNT, address ), slots[ i ] );
+					}
+					ProfileRegistry& registry = Registry();
+					std::lock_guard< std::mutex > guard( RegistryGuard( registry ) );
+					slots.swap( grown );
+					amountOfSlots = GROWN_AMOUNT;
+				}
+				ProfileSlot& SlotFor( const void* address, const char* typeName )
+				{
+					ProfileSlot* slot = &Probe( slots.get(), amountOfSlots, address );
+					if( slot->address.load( std::memory_order_relaxed ) == address )
+						return *slot;
+					if( ( amountUsed + 1 ) * 2 > amountOfSlots ) {
+						Grow();
+						slot = &Probe( slots.get(), amountOfSlots, address );
+					}
+					++amountUsed;
+					slot->typeName.store( typeName, std::memory_order_relaxed );
+					slot->address.store( address, std::memory_order_release );
+					return *slot;
+				}
+			};
+			//Only the owner writes, so there is no need for a read - modify - write.//
+			inline void Add( std::atomic< std::uint64_t >& counter, std::uint64_t amount ) {
+				counter.store( counter.load( std::memory_order_relaxed ) + amount, std::memory_order_relaxed );
+			}
+			typedef std::unordered_map< const void*, LockProfile > PROFILE_TOTALS;
+			void Accumulate( PROFILE_TOTALS& totals, ProfileSlot& slot, const void* address )
+			{
+				LockProfile& total = totals[ address ];
+				total.address = address;
+				const char* typeName = slot.typeName.load( std::memory_order_relaxed );
+				total.typeName = typeName;
+				total.aquires += slot.aquires.load( std::memory_order_relaxed );
+				total.contendedAquires += slot.contendedAquires.load( std::memory_order_relaxed );
+				total.totalWaitNanoseconds += slot.totalWaitNanoseconds.load( std::memory_order_relaxed );
+				total.maximumWaitNanoseconds = std::max( total.maximumWaitNanoseconds, 
+						slot.maximumWaitNanoseconds.load( std::memory_order_relaxed ) );
+				total.totalHoldNanoseconds += slot.totalHoldNanoseconds.load( std::memory_order_relaxed );
+			}
+			void Accumulate( PROFILE_TOTALS& totals, ThreadProfile& profile )
+			{
+				for( unsigned int i = 0; i < profile.amountOfSlots; ++i )
+				{
+					const void* address = profile.slots[ i ].address.load( std::memory_order_acquire );
+					if( address != nullptr )
+						Accumulate( totals, profile.slots[ i ], address );
+				}
+			}
+			struct ProfileRegistry
+			{
+				std::mutex guard;
+				std::vector< ThreadProfile* > live;
+				PROFILE_TOTALS retired;
+			};
+			ProfileRegistry& Registry()
+			{
+				static ProfileRegistry* registry = new ProfileRegistry();
+				return *registry;
+			}
+			std::mutex& RegistryGuard( ProfileRegistry& registry ) {
+				return ( registry.guard );
+			}
+			//Made on the first profiled aquire, folded into "retired" when the thread exits.//
+			struct ThreadProfileOwner
+			{
+				ThreadProfile* profile;
+				explicit ThreadProfileOwner() : profile( nullptr ) {
+				}
+				~ThreadProfileOwner()
+				{
+					if( profile == nullptr )
+						return;
+					ProfileRegistry& registry = Registry();
+					std::lock_guard< std::mutex > guard( registry.guard );
+					Accumulate( registry.retired, *profile );
+					registry.live.erase( std::find( registry.live.begin(), registry.live.end(), profile ) );
+					delete profile;
+				}
+				ThreadProfile& Get()
+				{
+					if( profile == nullptr )
+					{
+						profile = new ThreadProfile();
+						ProfileRegistry& registry = Registry();
+						std::lock_guard< std::mutex > guard( registry.guard );
+						registry.live.push_back( profile );
+					}
+					return *profile;
+				}
+			};
+			thread_local ThreadProfileOwner threadProfile;
+		}
+		void RecordAquire( const void* address, const char* typeName, bool contended, std::uint64_t waitNanoseconds )
+		{
+			ThreadProfile& profile = threadProfile.Get();
+			ProfileSlot& slot = profile.SlotFor( address, typeName );
+			Add( slot.aquires, 1 );
+			if( contended == true )
+			{
+				++profile.contentions;
+				Add( slot.contendedAquires, 1 );
+				Add( slot.totalWaitNanoseconds, waitNanoseconds );
+				if( waitNanoseconds > slot.maximumWaitNanoseconds.load( std::memory_order_relaxed ) )
+					slot.maximumWaitNanoseconds.store( waitNanoseconds, std::memory_order_relaxed );
+			}
+		}
+		void RecordRelease( const void* address, const char* typeName, std::uint64_t holdNanoseconds ) {
+			Add( threadProfile.Get().SlotFor( address, typeName ).totalHoldNanoseconds, holdNanoseconds );
+		}
+		std::uint64_t ThreadContentions() {
+			return ( threadProfile.Get().contentions );
+		}
+	}
+	void ContentionProfiler::Enable() {
+		enabled.store( true, std::memory_order_relaxed );
+	}
+	void ContentionProfiler::Disable() {
+		enabled.store( false, std::memory_order_relaxed );
+	}
+	std::vector< LockProfile > ContentionProfiler::Snapshot()
+	{
+		Implementation::ProfileRegistry& registry = Implementation::Registry();
+		Implementation::PROFILE_TOTALS totals;
+		{
+			std::lock_guard< std::mutex > guard( registry.guard );
+			totals = registry.retired;
+			const unsigned int AMOUNT_LIVE = registry.live.size();
+			for( unsigned int i = 0; i < AMOUNT_LIVE; ++i )
+				Implementation::Accumulate( totals, *registry.live[ i ] );
+		}
+		std::vector< LockProfile > profiles;
+		profiles.reserve( totals.size() );
+		for( auto& total : totals )
+			profiles.push_back( total.second );
+		return profiles;
+	}
+	std::vector< LockProfile > ContentionProfiler::Hottest( std::size_t amount )
+	{
+		std::vector< LockProfile > profiles = Snapshot();
+		std::sort( profiles.begin(), profiles.end(), []( const LockProfile& left, const LockProfile& right ) {
+				return ( left.totalWaitNanoseconds > right.totalWaitNanoseconds ); } );
+		if( profiles.size() > amount )
+			profiles.resize( amount );
+		return profiles;
+	}
+}
@@ -0,0 +1,64 @@
+/*
+Copyright (C) 2013 Christopher A. Greeley
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), 
+to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, 
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+#pragma once
+//Included by ThreadItAtomic.h once the platform is configured.//
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+namespace LibThreadIt
+{
+	//What one lock has cost, summed over every thread.//
+	struct LockProfile
+	{
+		//The protected data, or the AtomicResource for whole pool aquires.//
+		const void* address;
+		const char* typeName;
+		std::uint64_t aquires;
+		//Aquires that could not take the lock straight away.//
+		std::uint64_t contendedAquires;
+		std::uint64_t totalWaitNanoseconds;
+		std::uint64_t maximumWaitNanoseconds;
+		std::uint64_t totalHoldNanoseconds;
+	};
+	/*Counts aquires, contention, wait and hold time per Atomic and per AtomicResource. 
+	Always compiled in, when disabled an aquire pays one relaxed load. Each thread 
+	counts into its own table, nothing is shared until a snapshot sums the tables.*/
+	class ContentionProfiler
+	{
+		public: 
+			static void Enable();
+			static void Disable();
+			static bool IsEnabled() {
+				return ( enabled.load( std::memory_order_relaxed ) == true );
+			}
+			//Every lock seen since the program started, including threads that have exited.//
+			static std::vector< LockProfile > Snapshot();
+			//The "amount" locks with the most total wait, worst first.//
+			static std::vector< LockProfile > Hottest( std::size_t amount );
+		protected: 
+			static std::atomic< bool > enabled;
+	};
+	namespace Implementation
+	{
+		inline std::uint64_t ProfilerClock() {
+			return ( std::chrono::duration_cast< std::chrono::nanoseconds >( 
+					std::chrono::steady_clock::now().time_since_epoch() ).count() );
+		}
+		void RecordAquire( const void* address, const char* typeName, bool contended, std::uint64_t waitNanoseconds );
+		void RecordRelease( const void* address, const char* typeName, std::uint64_t holdNanoseconds );
+		//Contended aquires on this thread so far, lets a pool tell if any of its atomics waited.//
+		std::uint64_t ThreadContentions();
+	}
+}
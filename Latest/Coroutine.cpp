@@ -0,0 +1,35 @@
+/*
+Copyright (C) 2013 Christopher A. Greeley
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), 
+to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, 
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+#include <ThreadIt.h>
+
+namespace LibThreadIt
+{
+	#if defined( THREAD_IT_POSIX_PLATFORM ) && defined( __cpp_impl_coroutine )
+		namespace Implementation
+		{
+			bool HandleAwaiter::await_ready() {
+				return handle->IsComplete();
+			}
+			void HandleAwaiter::await_suspend( std::coroutine_handle<> coroutine_ )
+			{
+				coroutine = coroutine_;
+				/*We may be resumed, and this awaiter destroyed, before OnCompletion 
+				returns, so hold the handle on our own stack.*/
+				std::shared_ptr< ThreadHandle > completing = handle;
+				CoroutineResumer* resumer = this;
+				completing->OnCompletion( [ resumer ]() { WorkerPool::Global().Submit( resumer ); } );
+			}
+		}
+	#endif
+}
@@ -0,0 +1,145 @@
+/*
+Copyright (C) 2013 Christopher A. Greeley
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), 
+to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, 
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+#pragma once
+#include <Task.h>
+#if defined( THREAD_IT_POSIX_PLATFORM ) && defined( __cpp_impl_coroutine )
+	#include <coroutine>
+	#include <exception>
+	#include <type_traits>
+#endif
+
+/*Awaitables for C++20 coroutines, everything here compiles away without them. 
+Suspended coroutines are resumed on the worker pool, so thousands of them can wait 
+on handles and atomics without holding an OS thread each.*/
+namespace LibThreadIt
+{
+	#if defined( THREAD_IT_POSIX_PLATFORM ) && defined( __cpp_impl_coroutine )
+		struct ThreadHandle;
+		namespace Implementation
+		{
+			struct CoroutineResumer : public PoolTask
+			{
+				std::coroutine_handle<> coroutine;
+				virtual void RunOnWorker() {
+					coroutine.resume();
+				}
+			};
+			struct HandleAwaiter : public CoroutineResumer
+			{
+				std::shared_ptr< ThreadHandle > handle;
+				explicit HandleAwaiter( std::shared_ptr< ThreadHandle > handle_ ) : handle( handle_ ) {
+				}
+				bool await_ready();
+				void await_suspend( std::coroutine_handle<> coroutine_ );
+				void await_resume() {
+				}
+			};
+			/*Takes the lock without waiting if it can. Otherwise it queues on the lock 
+			word's control block, pinned so the block keeps standing for the object, and 
+			the release that frees the lock takes it for us and puts us on the pool. 
+			"IS_SHARED_T" waits for a read, shared with other readers, as Read does.*/
+			template< typename ATOMIC_TYPE_T, bool IS_SHARED_T >
+			struct AtomicAwaiter : public CoroutineResumer, public AsyncLockWaiter
+			{
+				typedef typename std::conditional< IS_SHARED_T, const ATOMIC_TYPE_T*, ATOMIC_TYPE_T* >::type DATA_T;
+				Atomic< ATOMIC_TYPE_T >* atomic;
+				//Pinned while we are queued on it, null once it is not.//
+				LockControlBlock* pinned;
+				//For the ContentionProfiler, 0 if it was off.//
+				std::uint64_t suspendedAt;
+				explicit AtomicAwaiter( Atomic< ATOMIC_TYPE_T >* atomic_ ) : atomic( atomic_ ), pinned( nullptr ), 
+						suspendedAt( 0 ) {
+				}
+				static void Resume( AsyncLockWaiter* waiter ) {
+					WorkerPool::Global().Submit( static_cast< AtomicAwaiter* >( waiter ) );
+				}
+				bool await_ready()
+				{
+					//Holding it exclusively already counts as being able to read.//
+					if( IS_SHARED_T == true )
+						return ( atomic->IsHeld() == true || atomic->TryAtomicAquireShared() == true );
+					if( atomic->didWrite == true || atomic->isCovered == true )
+						return ( true );
+					//Readers can not upgrade in place, same as AtomicAquire.//
+					if( atomic->didRead == true )
+						atomic->Release();
+					return atomic->TryAtomicAquire();
+				}
+				bool await_suspend( std::coroutine_handle<> coroutine_ )
+				{
+					coroutine = coroutine_;
+					resume = &AtomicAwaiter::Resume;
+					isShared = IS_SHARED_T;
+					if( ContentionProfiler::IsEnabled() == true )
+						suspendedAt = ProfilerClock();
+					pinned = LockTable::Pin( atomic->GetLockBlock(), atomic->GetLockKey() );
+					atomic->isBusy = &pinned->lock;
+					//Once queued we may be resumed, and destroyed, before this returns.//
+					if( pinned->AquireOrEnqueue( this ) == false )
+						return ( true );
+					pinned->Unpin();
+					pinned = nullptr;
+					return ( false );
+				}
+				DATA_T await_resume()
+				{
+					if( pinned != nullptr ) {
+						pinned->Unpin();
+						pinned = nullptr;
+					}
+					//The lock was taken for us while we were suspended.//
+					if( atomic->IsHeld() == false )
+					{
+						if( IS_SHARED_T == true )
+							atomic->didRead = true;
+						else
+							atomic->didWrite = true;
+						atomic->aquiredAt = 0;
+						if( suspendedAt != 0 ) {
+							atomic->aquiredAt = ProfilerClock();
+							RecordAquire( atomic->GetAddress(), atomic->id.name(), true, atomic->aquiredAt - suspendedAt );
+						}
+					}
+					return atomic->atomicData;
+				}
+			};
+		}
+		//"co_await handle" resumes once the handle's procedure has run.//
+		inline Implementation::HandleAwaiter operator co_await( std::shared_ptr< ThreadHandle > handle ) {
+			return Implementation::HandleAwaiter( handle );
+		}
+		/*Return type for a coroutine that starts on the calling thread and runs on its 
+		own from its first suspension, its frame is freed when it finishes.*/
+		struct ThreadItCoroutine
+		{
+			struct promise_type
+			{
+				ThreadItCoroutine get_return_object() {
+					return ThreadItCoroutine();
+				}
+				std::suspend_never initial_suspend() noexcept {
+					return std::suspend_never();
+				}
+				std::suspend_never final_suspend() noexcept {
+					return std::suspend_never();
+				}
+				void return_void() {
+				}
+				void unhandled_exception() {
+					std::terminate();
+				}
+			};
+		};
+	#endif
+}
@@ -0,0 +1,402 @@
+/*
+Copyright (C) 2013 Christopher A. Greeley
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), 
+to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, 
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+#pragma once
+#include <WorkerPool.h>
+#include <cassert>
+
+namespace LibThreadIt
+{
+	namespace Implementation
+	{
+		/*Callbacks to run once something finishes, a callback added after completion runs 
+		right away on the caller. A waiter that gives up takes its callback back out with 
+		Remove, so waiting again and again on something long lived does not pile them up. 
+		This is not lock free, it is a doubly linked list behind an AdaptiveLock, so Remove 
+		can unlink and free a node at once. The lock is only held for a few pointer writes.*/
+		class CompletionList
+		{
+			struct Node
+			{
+				std::function< void() > callback;
+				Node* previous;
+				Node* next;
+			};
+			//Only held to link or unlink, callbacks run outside of it.//
+			AdaptiveLock guard;
+			Node* first;
+			Node* last;
+			std::atomic< bool > isComplete;
+			public: 
+				//Names one added callback, nullptr if it already ran.//
+				typedef const void* REGISTRATION;
+				explicit CompletionList() : first( nullptr ), last( nullptr ), isComplete( false ) {
+				}
+				CompletionList( const CompletionList& other ) = delete;
+				~CompletionList()
+				{
+					while( first != nullptr ) {
+						Node* next = first->next;
+						delete first;
+						first = next;
+					}
+				}
+				REGISTRATION Add( std::function< void() > callback )
+				{
+					Node* node = new Node();
+					node->callback = callback;
+					node->next = nullptr;
+					guard.Lock();
+					if( isComplete.load( std::memory_order_relaxed ) == true ) {
+						guard.Unlock();
+						delete node;
+						callback();
+						return ( nullptr );
+					}
+					node->previous = last;
+					if( last == nullptr )
+						first = node;
+					else
+						last->next = node;
+					last = node;
+					guard.Unlock();
+					return ( node );
+				}
+				/*'true' if the callback will never run. 'false' if it already ran, or is 
+				running now, so anything it touches has to outlive the call.*/
+				bool Remove( REGISTRATION registration )
+				{
+					if( registration == nullptr )
+						return ( false );
+					Node* node = const_cast< Node* >( static_cast< const Node* >( registration ) );
+					guard.Lock();
+					//Complete owns every node from here on.//
+					if( isComplete.load( std::memory_order_relaxed ) == true ) {
+						guard.Unlock();
+						return ( false );
+					}
+					if( node->previous == nullptr )
+						first = node->next;
+					else
+						node->previous->next = node->next;
+					if( node->next == nullptr )
+						last = node->previous;
+					else
+						node->next->previous = node->previous;
+					guard.Unlock();
+					delete node;
+					return ( true );
+				}
+				//Runs every callback in the order they were added, only the first call does anything.//
+				void Complete()
+				{
+					guard.Lock();
+					if( isComplete.load( std::memory_order_relaxed ) == true ) {
+						guard.Unlock();
+						return;
+					}
+					Node* node = first;
+					first = nullptr;
+					last = nullptr;
+					isComplete.store( true, std::memory_order_release );
+					guard.Unlock();
+					while( node != nullptr ) {
+						Node* next = node->next;
+						node->callback();
+						delete node;
+						node = next;
+					}
+				}
+				bool IsComplete() {
+					return ( isComplete.load( std::memory_order_acquire ) );
+				}
+		};
+	}
+	#ifdef THREAD_IT_POSIX_PLATFORM
+		template< typename RESULT_T >
+		class Future;
+		namespace Implementation
+		{
+			//What "FutureState::isReady" holds.//
+			const std::uint32_t FUTURE_PENDING = 0;
+			const std::uint32_t FUTURE_READY = 1;
+			//Still pending, and a thread is parked on it, only then does MarkReady wake anyone.//
+			const std::uint32_t FUTURE_WAITED_ON = 2;
+			inline void MarkFutureReady( std::atomic< std::uint32_t >& isReady )
+			{
+				if( isReady.exchange( FUTURE_READY, std::memory_order_acq_rel ) == FUTURE_WAITED_ON )
+					WakeAddress( &isReady, true );
+			}
+			/*What a Future and its Promise share. The value is only constructed once it 
+			is set, so it does not have to be default constructible. Only the first 
+			SetValue gets to write it, readers never see it until it is ready.*/
+			template< typename RESULT_T >
+			struct FutureState
+			{
+				std::atomic< std::uint32_t > isReady;
+				//Claimed by the SetValue that writes the value, before it writes it.//
+				std::atomic< bool > isSet;
+				CompletionList continuations;
+				typename std::aligned_storage< sizeof( RESULT_T ), alignof( RESULT_T ) >::type storage;
+				explicit FutureState() : isReady( FUTURE_PENDING ), isSet( false ) {
+				}
+				FutureState( const FutureState& other ) = delete;
+				~FutureState() {
+					if( isReady.load( std::memory_order_acquire ) == FUTURE_READY )
+						Value().~RESULT_T();
+				}
+				//'false' if it was set already, "value" is then dropped.//
+				bool SetValue( const RESULT_T& value )
+				{
+					if( isSet.exchange( true, std::memory_order_acq_rel ) == true )
+						return ( false );
+					new( &storage ) RESULT_T( value );
+					MarkReady();
+					return ( true );
+				}
+				//Only once it is ready.//
+				RESULT_T& Value() {
+					return *reinterpret_cast< RESULT_T* >( &storage );
+				}
+				void MarkReady()
+				{
+					MarkFutureReady( isReady );
+					continuations.Complete();
+				}
+			};
+			template<>
+			struct FutureState< void >
+			{
+				std::atomic< std::uint32_t > isReady;
+				std::atomic< bool > isSet;
+				CompletionList continuations;
+				explicit FutureState() : isReady( FUTURE_PENDING ), isSet( false ) {
+				}
+				bool SetValue()
+				{
+					if( isSet.exchange( true, std::memory_order_acq_rel ) == true )
+						return ( false );
+					MarkReady();
+					return ( true );
+				}
+				void MarkReady()
+				{
+					MarkFutureReady( isReady );
+					continuations.Complete();
+				}
+			};
+			//Calls a continuation with the value, or with nothing for Future< void >.//
+			template< typename RESULT_T >
+			struct FutureInvoke
+			{
+				template< typename FUNCTION_T >
+				static auto Call( FUNCTION_T& function, FutureState< RESULT_T >& state ) -> decltype( function( state.Value() ) ) {
+					return function( state.Value() );
+				}
+			};
+			template<>
+			struct FutureInvoke< void >
+			{
+				template< typename FUNCTION_T >
+				static auto Call( FUNCTION_T& function, FutureState< void >& ) -> decltype( function() ) {
+					return function();
+				}
+			};
+			//Stores what a continuation returns, so "void" continuations need no special case.//
+			template< typename RESULT_T >
+			struct FutureFulfil
+			{
+				template< typename FUNCTION_T, typename SOURCE_T >
+				static void Call( FutureState< RESULT_T >& target, FUNCTION_T& function, FutureState< SOURCE_T >& source ) {
+					target.SetValue( FutureInvoke< SOURCE_T >::Call( function, source ) );
+				}
+			};
+			template<>
+			struct FutureFulfil< void >
+			{
+				template< typename FUNCTION_T, typename SOURCE_T >
+				static void Call( FutureState< void >& target, FUNCTION_T& function, FutureState< SOURCE_T >& source ) {
+					FutureInvoke< SOURCE_T >::Call( function, source );
+					target.SetValue();
+				}
+			};
+		}
+		//The producing side of a Future.//
+		template< typename RESULT_T >
+		class Promise
+		{
+			std::shared_ptr< Implementation::FutureState< RESULT_T > > state;
+			public: 
+				explicit Promise() : state( std::make_shared< Implementation::FutureState< RESULT_T > >() ) {
+				}
+				//Only the first call sets it, later ones return 'false' and change nothing.//
+				bool SetValue( const RESULT_T& value ) {
+					return state->SetValue( value );
+				}
+				Future< RESULT_T > GetFuture() {
+					return Future< RESULT_T >( state );
+				}
+		};
+		template<>
+		class Promise< void >
+		{
+			std::shared_ptr< Implementation::FutureState< void > > state;
+			public: 
+				explicit Promise() : state( std::make_shared< Implementation::FutureState< void > >() ) {
+				}
+				bool SetValue() {
+					return state->SetValue();
+				}
+				Future< void > GetFuture();
+		};
+		/*A result that will be ready later. Waiting never spins, and continuations run on 
+		the worker pool once the result is in, so chained work needs no thread parked in 
+		between. A default constructed Future has nothing behind it, everything but 
+		IsValid asserts on one.*/
+		template< typename RESULT_T >
+		class Future
+		{
+			std::shared_ptr< Implementation::FutureState< RESULT_T > > state;
+			public: 
+				explicit Future() {
+				}
+				explicit Future( std::shared_ptr< Implementation::FutureState< RESULT_T > > state_ ) : state( state_ ) {
+				}
+				bool IsValid() {
+					return ( state != nullptr );
+				}
+				bool IsReady() {
+					assert( state != nullptr && "Future used without a Promise behind it" );
+					return ( state->isReady.load( std::memory_order_acquire ) == Implementation::FUTURE_READY );
+				}
+				void Wait()
+				{
+					//A worker waiting on the pool keeps it moving instead of sleeping.//
+					Implementation::WorkerPool& pool = Implementation::WorkerPool::Global();
+					while( IsReady() == false )
+					{
+						if( pool.IsWorkerThread() == true ) {
+							if( pool.RunPendingTask() == false )
+								std::this_thread::yield();
+						}
+						else
+						{
+							std::uint32_t pending = Implementation::FUTURE_PENDING;
+							if( state->isReady.compare_exchange_strong( pending, Implementation::FUTURE_WAITED_ON, 
+									std::memory_order_relaxed ) == true || pending == Implementation::FUTURE_WAITED_ON )
+								Implementation::ParkOnAddress( &state->isReady, Implementation::FUTURE_WAITED_ON );
+						}
+					}
+				}
+				//Waits if need be, calling it on a Future< void > only waits.//
+				RESULT_T Get() {
+					Wait();
+					return GetReady();
+				}
+				/*Runs "continuation" on the worker pool with the result once it is ready, 
+				and gives back a Future for what the continuation returns.*/
+				template< typename FUNCTION_T >
+				auto Then( FUNCTION_T continuation ) -> Future< decltype( Implementation::FutureInvoke< RESULT_T >::Call( 
+						continuation, *std::declval< Implementation::FutureState< RESULT_T >* >() ) ) >
+				{
+					typedef decltype( Implementation::FutureInvoke< RESULT_T >::Call( continuation, *state ) ) NEXT_T;
+					assert( state != nullptr && "Future used without a Promise behind it" );
+					auto source = state;
+					auto target = std::make_shared< Implementation::FutureState< NEXT_T > >();
+					state->continuations.Add( [ source, target, continuation ]() {
+						Implementation::WorkerPool::Global().SubmitFunction( [ source, target, continuation ]() {
+							FUNCTION_T toCall = continuation;
+							Implementation::FutureFulfil< NEXT_T >::Call( *target, toCall, *source );
+						} );
+					} );
+					return Future< NEXT_T >( target );
+				}
+				//Runs "callback" on whichever thread completes the future, keep it short.//
+				void OnReady( std::function< void() > callback ) {
+					assert( state != nullptr && "Future used without a Promise behind it" );
+					state->continuations.Add( callback );
+				}
+			protected: 
+				RESULT_T GetReady() {
+					return state->Value();
+				}
+		};
+		template<>
+		inline void Future< void >::GetReady() {
+		}
+		inline Future< void > Promise< void >::GetFuture() {
+			return Future< void >( state );
+		}
+		//Ready when every future is, with their results in the same order.//
+		template< typename RESULT_T >
+		Future< std::vector< RESULT_T > > WhenAll( std::vector< Future< RESULT_T > > futures )
+		{
+			auto all = std::make_shared< Implementation::FutureState< std::vector< RESULT_T > > >();
+			auto remaining = std::make_shared< std::atomic< unsigned int > >( futures.size() + 1 );
+			auto sources = std::make_shared< std::vector< Future< RESULT_T > > >( futures );
+			std::function< void() > arrive = [ all, remaining, sources ]()
+			{
+				if( remaining->fetch_sub( 1, std::memory_order_acq_rel ) != 1 )
+					return;
+				std::vector< RESULT_T > results;
+				const unsigned int AMOUNT_OF_FUTURES = sources->size();
+				for( unsigned int i = 0; i < AMOUNT_OF_FUTURES; ++i )
+					results.push_back( ( *sources )[ i ].Get() );
+				all->SetValue( results );
+			};
+			const unsigned int AMOUNT_OF_FUTURES = futures.size();
+			for( unsigned int i = 0; i < AMOUNT_OF_FUTURES; ++i )
+				futures[ i ].OnReady( arrive );
+			//Our own count, so an empty list completes too.//
+			arrive();
+			return Future< std::vector< RESULT_T > >( all );
+		}
+		inline Future< void > WhenAll( std::vector< Future< void > > futures )
+		{
+			auto all = std::make_shared< Implementation::FutureState< void > >();
+			auto remaining = std::make_shared< std::atomic< unsigned int > >( futures.size() + 1 );
+			std::function< void() > arrive = [ all, remaining ]() {
+				if( remaining->fetch_sub( 1, std::memory_order_acq_rel ) == 1 )
+					all->SetValue();
+			};
+			const unsigned int AMOUNT_OF_FUTURES = futures.size();
+			for( unsigned int i = 0; i < AMOUNT_OF_FUTURES; ++i )
+				futures[ i ].OnReady( arrive );
+			arrive();
+			return Future< void >( all );
+		}
+		/*Ready as soon as one future is, with the position of the first one to finish. 
+		Nothing can finish in an empty list, so that is ready right away with 
+		"futures.size(), " the same as WaitAny on no handles.*/
+		template< typename RESULT_T >
+		Future< std::size_t > WhenAny( std::vector< Future< RESULT_T > > futures )
+		{
+			auto first = std::make_shared< Implementation::FutureState< std::size_t > >();
+			auto isDecided = std::make_shared< std::atomic< bool > >( false );
+			const unsigned int AMOUNT_OF_FUTURES = futures.size();
+			if( AMOUNT_OF_FUTURES == 0 ) {
+				first->SetValue( 0 );
+				return Future< std::size_t >( first );
+			}
+			for( unsigned int i = 0; i < AMOUNT_OF_FUTURES; ++i )
+			{
+				std::size_t position = i;
+				futures[ i ].OnReady( [ first, isDecided, position ]() {
+					if( isDecided->exchange( true, std::memory_order_acq_rel ) == false )
+						first->SetValue( position );
+				} );
+			}
+			return Future< std::size_t >( first );
+		}
+	#endif
+}
@@ -0,0 +1,212 @@
+/*
+Copyright (C) 2013 Christopher A. Greeley
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), 
+to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, 
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+#include <AtomicResource.h>
+#include <new>
+
+namespace LibThreadIt
+{
+	namespace Implementation
+	{
+		bool LockControlBlock::AquireOrEnqueue( AsyncLockWaiter* waiter )
+		{
+			AsyncLockWaiter* handed;
+			{
+				AutoAtomic guard( &waitersGuard );
+				waiter->next = nullptr;
+				if( lastWaiter == nullptr )
+					firstWaiter.store( waiter, std::memory_order_relaxed );
+				else
+					lastWaiter->next = waiter;
+				lastWaiter = waiter;
+				std::atomic_thread_fence( std::memory_order_seq_cst );
+				//If it is free after all, it goes to whoever has waited longest.//
+				handed = PopHanded();
+			}
+			return ResumeHanded( handed, waiter );
+		}
+		void LockControlBlock::HandToWaiter()
+		{
+			AsyncLockWaiter* handed;
+			{
+				AutoAtomic guard( &waitersGuard );
+				handed = PopHanded();
+			}
+			ResumeHanded( handed, nullptr );
+		}
+		AsyncLockWaiter* LockControlBlock::PopWaiter()
+		{
+			AsyncLockWaiter* first = firstWaiter.load( std::memory_order_relaxed );
+			firstWaiter.store( first->next, std::memory_order_relaxed );
+			if( first->next == nullptr )
+				lastWaiter = nullptr;
+			return first;
+		}
+		AsyncLockWaiter* LockControlBlock::PopHanded()
+		{
+			AsyncLockWaiter* first = firstWaiter.load( std::memory_order_relaxed );
+			if( first == nullptr || ( ( first->isShared == true ) ? lock.TryLockShared() : lock.TryLock() ) == false )
+				return ( nullptr );
+			AsyncLockWaiter* last = PopWaiter();
+			//Readers share it, stopping at the first writer, or once a waiting thread keeps readers out.//
+			while( last->isShared == true && firstWaiter.load( std::memory_order_relaxed ) != nullptr && 
+					firstWaiter.load( std::memory_order_relaxed )->isShared == true && lock.TryLockShared() == true )
+				last = PopWaiter();
+			last->next = nullptr;
+			return first;
+		}
+		bool LockControlBlock::ResumeHanded( AsyncLockWaiter* handed, AsyncLockWaiter* skipped )
+		{
+			bool wasHanded = false;
+			while( handed != nullptr )
+			{
+				//Once resumed it may be gone.//
+				AsyncLockWaiter* next = handed->next;
+				if( handed == skipped )
+					wasHanded = true;
+				else
+					handed->resume( handed );
+				handed = next;
+			}
+			return wasHanded;
+		}
+		LockControlBlock* LockTable::Find( const LockKey& key )
+		{
+			Stripe& stripe = StripeOf( key.address );
+			LockControlBlock* found = Search( stripe, key );
+			if( found != nullptr )
+				return found;
+			AutoAtomic guard( &stripe.claimGuard );
+			found = Search( stripe, key );
+			if( found != nullptr )
+				return found;
+			return Claim( stripe, key );
+		}
+		LockControlBlock* LockTable::Lock( LockControlBlock* block, const LockKey& key, bool isShared )
+		{
+			while( true )
+			{
+				if( block == nullptr )
+					block = Find( key );
+				if( ( ( isShared == true ) ? block->lock.TryLockShared() : block->lock.TryLock() ) == true )
+				{
+					if( block->IsFor( key ) == true )
+						return block;
+					//Handed to another object since it was found.//
+					Unlock( block, isShared );
+					block = nullptr;
+					continue;
+				}
+				//Only wait on a block that can not be handed to another object meanwhile.//
+				if( block->Pin( key ) == false ) {
+					block = nullptr;
+					continue;
+				}
+				if( isShared == true )
+					block->lock.LockShared();
+				else
+					block->lock.Lock();
+				block->Unpin();
+				return block;
+			}
+		}
+		LockControlBlock* LockTable::TryLock( LockControlBlock* block, const LockKey& key, bool isShared )
+		{
+			while( true )
+			{
+				if( block == nullptr )
+					block = Find( key );
+				if( ( ( isShared == true ) ? block->lock.TryLockShared() : block->lock.TryLock() ) == true )
+				{
+					if( block->IsFor( key ) == true )
+						return block;
+					Unlock( block, isShared );
+					block = nullptr;
+					continue;
+				}
+				//Held, but maybe for another object.//
+				LockControlBlock* current = Find( key );
+				if( current == block )
+					return ( nullptr );
+				block = current;
+			}
+		}
+		LockControlBlock* LockTable::Pin( LockControlBlock* block, const LockKey& key )
+		{
+			while( true )
+			{
+				if( block == nullptr )
+					block = Find( key );
+				if( block->Pin( key ) == true )
+					return block;
+				block = nullptr;
+			}
+		}
+		LockTable::Stripe& LockTable::StripeOf( const void* address )
+		{
+			//Never destroyed, Atomics may still be let go of during static destruction.//
+			static Stripe* stripes = []() {
+					Stripe* made = static_cast< Stripe* >( AllocateInterleaved( AMOUNT_OF_STRIPES * sizeof( Stripe ) ) );
+					for( std::size_t i = 0; i < AMOUNT_OF_STRIPES; ++i )
+						new( &made[ i ] ) Stripe();
+					return made;
+				}();
+			//Objects are rarely smaller than 16 bytes, do not let the low bits pick the stripe.//
+			std::size_t hash = reinterpret_cast< std::size_t >( address ) >> 4;
+			hash ^= hash >> 10;
+			hash ^= hash >> 20;
+			return stripes[ hash % AMOUNT_OF_STRIPES ];
+		}
+		LockControlBlock* LockTable::Search( Stripe& stripe, const LockKey& key )
+		{
+			for( Stripe* at = &stripe; at != nullptr; at = at->overflow.load( std::memory_order_acquire ) )
+				for( std::size_t i = 0; i < BLOCKS_PER_STRIPE; ++i )
+					if( at->blocks[ i ].IsFor( key ) == true )
+						return &at->blocks[ i ];
+			return ( nullptr );
+		}
+		LockControlBlock* LockTable::Claim( Stripe& stripe, const LockKey& key )
+		{
+			Stripe* last = &stripe;
+			for( Stripe* at = &stripe; at != nullptr; at = at->overflow.load( std::memory_order_acquire ) )
+			{
+				last = at;
+				for( std::size_t i = 0; i < BLOCKS_PER_STRIPE; ++i )
+				{
+					LockControlBlock& block = at->blocks[ i ];
+					//Nothing may wait on it, nor hold it.//
+					std::uint32_t unpinned = 0;
+					if( block.pins.compare_exchange_strong( unpinned, LockControlBlock::CLAIMED, 
+							std::memory_order_acquire, std::memory_order_relaxed ) == false )
+						continue;
+					if( block.lock.TryLock() == false ) {
+						block.pins.fetch_sub( LockControlBlock::CLAIMED, std::memory_order_release );
+						continue;
+					}
+					block.type.store( key.type, std::memory_order_relaxed );
+					block.address.store( key.address, std::memory_order_relaxed );
+					//A holder checks the object after locking, a waiter after pinning, both see it.//
+					block.lock.Unlock();
+					block.pins.fetch_sub( LockControlBlock::CLAIMED, std::memory_order_release );
+					return &block;
+				}
+			}
+			//Every block is busy, the stripe grows.//
+			Stripe* added = new Stripe();
+			added->blocks[ 0 ].type.store( key.type, std::memory_order_relaxed );
+			added->blocks[ 0 ].address.store( key.address, std::memory_order_relaxed );
+			last->overflow.store( added, std::memory_order_release );
+			return &added->blocks[ 0 ];
+		}
+	}
+}
@@ -0,0 +1,175 @@
+/*
+Copyright (C) 2013 Christopher A. Greeley
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), 
+to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, 
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+#pragma once
+//Included by ThreadItAtomic.h once the platform is configured.//
+#include <AdaptiveLock.h>
+#include <Numa.h>
+#include <typeinfo>
+
+namespace LibThreadIt
+{
+	namespace Implementation
+	{
+		const std::size_t CACHE_LINE_SIZE = 64;
+		/*The object a lock word stands for, the object at an address seen as a given 
+		type. A struct and its first member share an address but are different objects, 
+		so they get different lock words and holding one does not wait for the other; 
+		likewise "int" and "const int" are the same type here, but a base and a derived 
+		class are not.*/
+		struct LockKey
+		{
+			const void* address;
+			const std::type_info* type;
+			bool operator==( const LockKey& other ) const {
+				return ( address == other.address && *type == *other.type );
+			}
+			bool operator!=( const LockKey& other ) const {
+				return ( ( *this == other ) == false );
+			}
+			//Pools aquire in this order, so they can not deadlock each other.//
+			bool operator<( const LockKey& other ) const
+			{
+				if( address != other.address )
+					return ( std::less< const void* >()( address, other.address ) );
+				return ( type->before( *other.type ) );
+			}
+		};
+		//A coroutine suspended until a lock word is free, see Coroutine.h.//
+		struct AsyncLockWaiter
+		{
+			AsyncLockWaiter* next;
+			//Called once the lock has been taken on the waiter's behalf.//
+			void (* resume )( AsyncLockWaiter* );
+			//Shared with other readers rather than exclusive.//
+			bool isShared;
+		};
+		/*A lock word, alone on its cache line, along with the coroutines waiting for it. 
+		Waiting coroutines do not park a thread, each release hands the lock to the 
+		first of them, and if that is a reader to the readers queued right behind it. 
+		Which object the block stands for changes over time, see LockTable.*/
+		struct LockControlBlock
+		{
+			AdaptiveLock lock;
+			AdaptiveLock waitersGuard;
+			std::atomic< AsyncLockWaiter* > firstWaiter;
+			AsyncLockWaiter* lastWaiter;
+			/*Threads and coroutines waiting for "lock, " the block keeps standing for 
+			its object while any are. The top bit is set while the LockTable hands the 
+			block to another object.*/
+			std::atomic< std::uint32_t > pins;
+			std::atomic< const void* > address;
+			std::atomic< const std::type_info* > type;
+			char padding[ CACHE_LINE_SIZE - 2 * sizeof( AdaptiveLock ) - 
+					sizeof( std::atomic< AsyncLockWaiter* > ) - sizeof( AsyncLockWaiter* ) - 
+					sizeof( std::atomic< std::uint32_t > ) - sizeof( std::atomic< const void* > ) - 
+					sizeof( std::atomic< const std::type_info* > ) - sizeof( std::uint32_t ) ];
+			static const std::uint32_t CLAIMED = 1u << 31;
+			explicit LockControlBlock() : firstWaiter( nullptr ), lastWaiter( nullptr ), pins( 0 ), 
+					address( nullptr ), type( nullptr ) {
+			}
+			//Every lock word the table hands out is the start of one of these.//
+			static LockControlBlock* Of( AdaptiveLock* lock ) {
+				return reinterpret_cast< LockControlBlock* >( lock );
+			}
+			/*Only settled while "lock" is held or the block is pinned, otherwise a hint 
+			that has to be checked again once it is.*/
+			bool IsFor( const LockKey& key ) const
+			{
+				const std::type_info* current = type.load( std::memory_order_relaxed );
+				return ( address.load( std::memory_order_relaxed ) == key.address && 
+						current != nullptr && *current == *key.type );
+			}
+			//'false' if the block does not stand for "key, " the block is not pinned then.//
+			bool Pin( const LockKey& key )
+			{
+				if( ( pins.fetch_add( 1, std::memory_order_acquire ) & CLAIMED ) == 0 && IsFor( key ) == true )
+					return ( true );
+				Unpin();
+				return ( false );
+			}
+			void Unpin() {
+				pins.fetch_sub( 1, std::memory_order_release );
+			}
+			/*'true' if the lock was taken for "waiter" straight away, shared if it is a 
+			reader, otherwise it is queued and resumed once a release hands the lock 
+			over. Call with the block pinned.*/
+			bool AquireOrEnqueue( AsyncLockWaiter* waiter );
+			//Call after every release of "lock."//
+			void AfterRelease()
+			{
+				//Pairs with the fence in AquireOrEnqueue, either we see the waiter or it sees the lock free.//
+				std::atomic_thread_fence( std::memory_order_seq_cst );
+				if( firstWaiter.load( std::memory_order_relaxed ) != nullptr )
+					HandToWaiter();
+			}
+			protected: 
+				void HandToWaiter();
+				AsyncLockWaiter* PopWaiter();
+				/*Takes the lock for the first waiter and any readers right behind a reader, 
+				and unqueues them. Call holding "waitersGuard."*/
+				AsyncLockWaiter* PopHanded();
+				//Resumes all of "handed" but "skipped, " 'true' if "skipped" was one of them.//
+				static bool ResumeHanded( AsyncLockWaiter* handed, AsyncLockWaiter* skipped );
+		};
+		static_assert( sizeof( LockControlBlock ) == CACHE_LINE_SIZE, "A lock word gets a cache line to itself." );
+		/*Hands out the lock word for a protected object. Lock words live in a fixed 
+		table striped by address and are never freed, so an Atomic only keeps a pointer 
+		to the one it last used, and copying it copies the pointer. Each stripe has a few 
+		blocks, a block stands for one object at a time and goes to another object only 
+		once nothing holds, waits for, or is queued on it. An Atomic's pointer is a hint: 
+		once it has the lock it checks the block still stands for its object, and only 
+		waits on a block it has pinned to it. A stripe with every block busy gets more, 
+		so objects never share a lock word. Every Atomic for the same object gets the 
+		same lock word, no matter which pool it was branched from.*/
+		class LockTable
+		{
+			public: 
+				//The block standing for "key" right now, one is handed to it if none is. Never waits for the lock.//
+				static LockControlBlock* Find( const LockKey& key );
+				/*Waits for "key's" lock word, and returns the block it was taken on. "block" 
+				is where it was last seen, null if nowhere.*/
+				static LockControlBlock* Lock( LockControlBlock* block, const LockKey& key, bool isShared );
+				//As Lock but never waits, null if the lock word is held.//
+				static LockControlBlock* TryLock( LockControlBlock* block, const LockKey& key, bool isShared );
+				//A block standing for "key" that keeps doing so until Unpin, see Lock.//
+				static LockControlBlock* Pin( LockControlBlock* block, const LockKey& key );
+				//Gives back a lock word Lock or TryLock took.//
+				static void Unlock( LockControlBlock* block, bool isShared )
+				{
+					if( isShared == true )
+						block->lock.UnlockShared();
+					else
+						block->lock.Unlock();
+					block->AfterRelease();
+				}
+			protected: 
+				static const std::size_t AMOUNT_OF_STRIPES = 1024;
+				static const std::size_t BLOCKS_PER_STRIPE = 4;
+				struct alignas( CACHE_LINE_SIZE ) Stripe
+				{
+					LockControlBlock blocks[ BLOCKS_PER_STRIPE ];
+					//Held to hand a block to another object, looking one up takes no lock.//
+					AdaptiveLock claimGuard;
+					//Made once every block was busy, never freed.//
+					std::atomic< Stripe* > overflow;
+					explicit Stripe() : overflow( nullptr ) {
+					}
+				};
+				static Stripe& StripeOf( const void* address );
+				static LockControlBlock* Search( Stripe& stripe, const LockKey& key );
+				//Call holding "stripe's" guard, after Search came back empty.//
+				static LockControlBlock* Claim( Stripe& stripe, const LockKey& key );
+		};
+	}
+}
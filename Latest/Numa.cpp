@@ -0,0 +1,270 @@
+/*
+Copyright (C) 2013 Christopher A. Greeley
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), 
+to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, 
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+#include <AtomicResource.h>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#ifdef __linux__
+	#include <sched.h>
+	#include <sys/mman.h>
+	#include <sys/syscall.h>
+	#include <unistd.h>
+#endif
+
+namespace LibThreadIt
+{
+	namespace
+	{
+		//"0-3,8,10-11" to { 0, 1, 2, 3, 8, 10, 11 }.//
+		std::vector< int > ParseCpuList( const std::string& list )
+		{
+			std::vector< int > cpus;
+			std::stringstream ranges( list );
+			std::string range;
+			while( std::getline( ranges, range, ',' ) )
+			{
+				int first, last;
+				const int MATCHED = std::sscanf( range.c_str(), "%d-%d", &first, &last );
+				if( MATCHED == 1 )
+					last = first;
+				else if( MATCHED != 2 )
+					continue;
+				for( int cpu = first; cpu <= last; ++cpu )
+					cpus.push_back( cpu );
+			}
+			return cpus;
+		}
+	}
+	NumaTopology::NumaTopology() : isSimulated( false )
+	{
+		if( ReadSysfs() == false )
+		{
+			nodeCpus.assign( 1, std::vector< int >() );
+			const unsigned int AMOUNT_OF_CPUS = std::max( std::thread::hardware_concurrency(), 1u );
+			for( unsigned int i = 0; i < AMOUNT_OF_CPUS; ++i )
+				nodeCpus[ 0 ].push_back( i );
+		}
+		IndexCpus();
+	}
+	const NumaTopology& NumaTopology::System()
+	{
+		static NumaTopology* system = nullptr;
+		static std::once_flag isRead;
+		std::call_once( isRead, []() {
+				const char* simulatedNodes = std::getenv( "THREAD_IT_NUMA_NODES" );
+				if( simulatedNodes != nullptr && std::atoi( simulatedNodes ) > 0 )
+					system = new NumaTopology( Simulated( std::atoi( simulatedNodes ), 
+							std::max( std::thread::hardware_concurrency(), 1u ) ) );
+				else
+					system = new NumaTopology();
+			} );
+		return *system;
+	}
+	NumaTopology NumaTopology::Simulated( unsigned int amountOfNodes, unsigned int amountOfCpus )
+	{
+		NumaTopology topology;
+		topology.isSimulated = true;
+		topology.nodeCpus.assign( std::max( amountOfNodes, 1u ), std::vector< int >() );
+		for( unsigned int cpu = 0; cpu < amountOfCpus; ++cpu )
+			topology.nodeCpus[ cpu % topology.nodeCpus.size() ].push_back( cpu );
+		for( unsigned int i = 0; i < topology.nodeCpus.size(); ++i )
+			if( topology.nodeCpus[ i ].empty() == true )
+				topology.nodeCpus[ i ].push_back( 0 );
+		topology.IndexCpus();
+		return topology;
+	}
+	unsigned int NumaTopology::NodeOfCpu( int cpu ) const
+	{
+		if( cpu < 0 || ( std::size_t ) cpu >= cpuNodes.size() )
+			return 0;
+		return cpuNodes[ cpu ];
+	}
+	unsigned int NumaTopology::CurrentNode() const
+	{
+		#ifdef __linux__
+			return NodeOfCpu( sched_getcpu() );
+		#else
+			return 0;
+		#endif
+	}
+	void NumaTopology::IndexCpus()
+	{
+		cpuNodes.clear();
+		const unsigned int AMOUNT_OF_NODES = nodeCpus.size();
+		//A CPU shared by simulated nodes belongs to the first of them.//
+		for( unsigned int node = AMOUNT_OF_NODES; node-- > 0; )
+		{
+			const unsigned int AMOUNT_OF_CPUS = nodeCpus[ node ].size();
+			for( unsigned int i = 0; i < AMOUNT_OF_CPUS; ++i )
+			{
+				const int CPU = nodeCpus[ node ][ i ];
+				if( ( std::size_t ) CPU >= cpuNodes.size() )
+					cpuNodes.resize( CPU + 1, 0 );
+				cpuNodes[ CPU ] = node;
+			}
+		}
+	}
+	bool NumaTopology::ReadSysfs()
+	{
+		#ifdef __linux__
+			std::ifstream online( "/sys/devices/system/node/online" );
+			std::string nodeList;
+			if( !( online >> nodeList ) )
+				return ( false );
+			std::vector< int > nodes = ParseCpuList( nodeList );
+			if( nodes.empty() == true )
+				return ( false );
+			//Node numbers may have gaps, ours are dense, a missing node is left empty.//
+			nodeCpus.assign( nodes.back() + 1, std::vector< int >() );
+			const unsigned int AMOUNT_OF_NODES = nodes.size();
+			for( unsigned int i = 0; i < AMOUNT_OF_NODES; ++i )
+			{
+				std::stringstream path;
+				path << "/sys/devices/system/node/node" << nodes[ i ] << "/cpulist";
+				std::ifstream cpuList( path.str().c_str() );
+				std::string cpus;
+				if( cpuList >> cpus )
+					nodeCpus[ nodes[ i ] ] = ParseCpuList( cpus );
+			}
+			return ( true );
+		#else
+			return ( false );
+		#endif
+	}
+	namespace Implementation
+	{
+		namespace
+		{
+			const std::size_t NODE_BLOCK_SIZE = CACHE_LINE_SIZE;
+			const std::size_t NODE_SIZE_CLASSES = 16;
+			const std::size_t NODE_CHUNK_SIZE = 64 * 1024;
+			#ifdef __linux__
+				//From numaif.h, spelled out so we do not need libnuma.//
+				const int MEMORY_POLICY_PREFERRED = 1;
+				const int MEMORY_POLICY_INTERLEAVE = 3;
+			#endif
+			//Fresh pages for "node", bound to it unless the topology is simulated.//
+			void* MapOnNode( std::size_t size, int node )
+			{
+				#ifdef __linux__
+					void* memory = mmap( nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0 );
+					if( memory == MAP_FAILED )
+						throw std::bad_alloc();
+					if( NumaTopology::System().IsSimulated() == false && node < 64 ) {
+						unsigned long nodeMask = 1ul << node;
+						//The kernel reads one bit less than "maxnode," 65 covers nodes 0 to 63.//
+						syscall( SYS_mbind, memory, size, MEMORY_POLICY_PREFERRED, &nodeMask, 65, 0 );
+					}
+					return memory;
+				#else
+					return ::operator new( size );
+				#endif
+			}
+			void UnmapOnNode( void* memory, std::size_t size )
+			{
+				#ifdef __linux__
+					munmap( memory, size );
+				#else
+					::operator delete( memory );
+				#endif
+			}
+			//Free lists for blocks of 64, 128, ... 1024 bytes on one node.//
+			struct NodeHeap
+			{
+				AdaptiveLock guard;
+				RecycledBlock* freeBlocks[ NODE_SIZE_CLASSES ];
+				char* chunk;
+				std::size_t usedInChunk;
+				explicit NodeHeap() : chunk( nullptr ), usedInChunk( NODE_CHUNK_SIZE ) {
+					for( std::size_t i = 0; i < NODE_SIZE_CLASSES; ++i )
+						freeBlocks[ i ] = nullptr;
+				}
+			};
+			NodeHeap& HeapOf( int node )
+			{
+				static std::vector< NodeHeap >* heaps = new std::vector< NodeHeap >( 
+						NumaTopology::System().GetAmountOfNodes() );
+				return ( *heaps )[ node ];
+			}
+			//Nothing at all still takes the smallest block.//
+			std::size_t SizeClassOf( std::size_t size )
+			{
+				if( size == 0 )
+					return ( 0 );
+				return ( ( size + NODE_BLOCK_SIZE - 1 ) / NODE_BLOCK_SIZE ) - 1;
+			}
+			bool IsOnAnyNode( int node ) {
+				return ( node < 0 || ( unsigned int ) node >= NumaTopology::System().GetAmountOfNodes() );
+			}
+		}
+		void* AllocateOnNode( std::size_t size, int node )
+		{
+			if( IsOnAnyNode( node ) == true )
+				return ::operator new( size );
+			const std::size_t SIZE_CLASS = SizeClassOf( size );
+			if( SIZE_CLASS >= NODE_SIZE_CLASSES )
+				return MapOnNode( size, node );
+			NodeHeap& heap = HeapOf( node );
+			AutoAtomic guard( &heap.guard );
+			RecycledBlock* block = heap.freeBlocks[ SIZE_CLASS ];
+			if( block != nullptr ) {
+				heap.freeBlocks[ SIZE_CLASS ] = block->next;
+				return block;
+			}
+			const std::size_t BLOCK_SIZE = ( SIZE_CLASS + 1 ) * NODE_BLOCK_SIZE;
+			if( heap.usedInChunk + BLOCK_SIZE > NODE_CHUNK_SIZE ) {
+				//Chunks are never unmapped, their blocks go round the free lists.//
+				heap.chunk = static_cast< char* >( MapOnNode( NODE_CHUNK_SIZE, node ) );
+				heap.usedInChunk = 0;
+			}
+			void* memory = heap.chunk + heap.usedInChunk;
+			heap.usedInChunk += BLOCK_SIZE;
+			return memory;
+		}
+		void FreeOnNode( void* memory, std::size_t size, int node )
+		{
+			if( IsOnAnyNode( node ) == true ) {
+				::operator delete( memory );
+				return;
+			}
+			const std::size_t SIZE_CLASS = SizeClassOf( size );
+			if( SIZE_CLASS >= NODE_SIZE_CLASSES ) {
+				UnmapOnNode( memory, size );
+				return;
+			}
+			NodeHeap& heap = HeapOf( node );
+			AutoAtomic guard( &heap.guard );
+			RecycledBlock* block = static_cast< RecycledBlock* >( memory );
+			block->next = heap.freeBlocks[ SIZE_CLASS ];
+			heap.freeBlocks[ SIZE_CLASS ] = block;
+		}
+		void* AllocateInterleaved( std::size_t size )
+		{
+			#ifdef __linux__
+				void* memory = mmap( nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0 );
+				if( memory == MAP_FAILED )
+					throw std::bad_alloc();
+				const unsigned int AMOUNT_OF_NODES = NumaTopology::System().GetAmountOfNodes();
+				if( NumaTopology::System().IsSimulated() == false && AMOUNT_OF_NODES > 1 && AMOUNT_OF_NODES <= 64 ) {
+					unsigned long nodeMask = ( AMOUNT_OF_NODES == 64 ) ? ~0ul : ( ( 1ul << AMOUNT_OF_NODES ) - 1 );
+					syscall( SYS_mbind, memory, size, MEMORY_POLICY_INTERLEAVE, &nodeMask, 65, 0 );
+				}
+				return memory;
+			#else
+				return ::operator new( size, std::align_val_t( CACHE_LINE_SIZE ) );
+			#endif
+		}
+	}
+}
@@ -0,0 +1,92 @@
+/*
+Copyright (C) 2013 Christopher A. Greeley
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), 
+to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, 
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+#pragma once
+//Included by LockTable.h, it only needs the standard library.//
+#include <cstddef>
+#include <vector>
+
+namespace LibThreadIt
+{
+	/*Which CPUs belong to which memory node. Read from sysfs, a machine without NUMA 
+	(or without sysfs) is one node holding every CPU. Setting THREAD_IT_NUMA_NODES 
+	in the environment splits the CPUs into that many simulated nodes instead, so 
+	node aware code can be exercised on a single socket machine.*/
+	class NumaTopology
+	{
+		public: 
+			explicit NumaTopology();
+			//The machine's topology, read once.//
+			static const NumaTopology& System();
+			/*"amountOfNodes" nodes sharing "amountOfCpus" CPUs round robin, with no 
+			real memory behind them. A node gets CPU 0 if there are fewer CPUs than nodes.*/
+			static NumaTopology Simulated( unsigned int amountOfNodes, unsigned int amountOfCpus );
+			unsigned int GetAmountOfNodes() const {
+				return nodeCpus.size();
+			}
+			const std::vector< int >& GetCpus( unsigned int node ) const {
+				return nodeCpus[ node ];
+			}
+			//0 for a CPU we know nothing about.//
+			unsigned int NodeOfCpu( int cpu ) const;
+			//Memory can only be bound to nodes that exist.//
+			bool IsSimulated() const {
+				return isSimulated;
+			}
+			//The node the calling thread is running on right now.//
+			unsigned int CurrentNode() const;
+		protected: 
+			std::vector< std::vector< int > > nodeCpus;
+			std::vector< unsigned int > cpuNodes;
+			bool isSimulated;
+			void IndexCpus();
+			bool ReadSysfs();
+	};
+	namespace Implementation
+	{
+		/*Memory that prefers a given node of NumaTopology::System(). Small sizes come 
+		from per node free lists carved out of chunks bound to the node, so freeing 
+		and reallocating stays on the node. -1 means no preference.*/
+		void* AllocateOnNode( std::size_t size, int node );
+		void FreeOnNode( void* memory, std::size_t size, int node );
+		/*Cache line aligned memory spread page by page over every node, for tables 
+		every node uses alike. Kept for the life of the process.*/
+		void* AllocateInterleaved( std::size_t size );
+		//For std::allocate_shared, see RecyclingAllocator.//
+		template< typename TYPE_T >
+		struct NodeAllocator
+		{
+			typedef TYPE_T value_type;
+			int node;
+			explicit NodeAllocator( int node_ ) : node( node_ ) {
+			}
+			template< typename OTHER_T >
+			NodeAllocator( const NodeAllocator< OTHER_T >& other ) : node( other.node ) {
+			}
+			TYPE_T* allocate( std::size_t amount ) {
+				return static_cast< TYPE_T* >( AllocateOnNode( amount * sizeof( TYPE_T ), node ) );
+			}
+			void deallocate( TYPE_T* memory, std::size_t amount ) {
+				FreeOnNode( memory, amount * sizeof( TYPE_T ), node );
+			}
+			template< typename OTHER_T >
+			bool operator==( const NodeAllocator< OTHER_T >& other ) const {
+				return ( node == other.node );
+			}
+			template< typename OTHER_T >
+			bool operator!=( const NodeAllocator< OTHER_T >& other ) const {
+				return ( node != other.node );
+			}
+		};
+	}
+}
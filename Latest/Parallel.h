@@ -0,0 +1,111 @@
+/*
+Copyright (C) 2013 Christopher A. Greeley
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), 
+to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, 
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+#pragma once
+#include <Task.h>
+
+namespace LibThreadIt
+{
+	#ifdef THREAD_IT_POSIX_PLATFORM
+		//Indices [ begin, end ).//
+		struct IndexRange
+		{
+			std::size_t begin, end;
+			explicit IndexRange( std::size_t begin_, std::size_t end_ ) : begin( begin_ ), end( end_ ) {
+			}
+			std::size_t Size() const {
+				return ( ( end > begin ) ? end - begin : 0 );
+			}
+		};
+		namespace Implementation
+		{
+			//Splitting halves the range each time, so this bounds the recursion for any std::size_t.//
+			const unsigned int MAXIMUM_SPLITS = 64;
+			//Chunks per worker when the grain is picked for the caller, a few extra so stealing can balance.//
+			const std::size_t CHUNKS_PER_WORKER = 8;
+			inline std::size_t PickGrain( const IndexRange& range, std::size_t grain )
+			{
+				if( grain != 0 )
+					return ( grain );
+				std::size_t chunks = WorkerPool::Global().GetAmountOfWorkers() * CHUNKS_PER_WORKER;
+				grain = range.Size() / chunks;
+				return ( ( grain == 0 ) ? 1 : grain );
+			}
+			/*Hands the upper half to the pool until what is left is no bigger than grain, 
+			runs that, then joins the halves. Idle workers steal the biggest halves first.*/
+			template< typename BODY_T >
+			void ParallelForSplit( std::size_t begin, std::size_t end, std::size_t grain, BODY_T& body )
+			{
+				Task< void > pending[ MAXIMUM_SPLITS ];
+				unsigned int amountPending = 0;
+				while( end - begin > grain )
+				{
+					std::size_t middle = begin + ( end - begin ) / 2;
+					pending[ amountPending++ ] = ThreadItTask( [ middle, end, grain, &body ]() {
+							ParallelForSplit( middle, end, grain, body );
+						} );
+					end = middle;
+				}
+				for( std::size_t i = begin; i < end; ++i )
+					body( i );
+				while( amountPending > 0 )
+					pending[ --amountPending ].Join();
+			}
+			/*Same splitting as ParallelForSplit. Every chunk reduces into its own partial, 
+			and partials are combined as the halves are joined, so nothing is shared and 
+			nothing is locked. Partials are combined left to right, combine only needs to 
+			be associative.*/
+			template< typename VALUE_T, typename BODY_T, typename COMBINE_T >
+			VALUE_T ParallelReduceSplit( std::size_t begin, std::size_t end, std::size_t grain, 
+					const VALUE_T& identity, BODY_T& body, COMBINE_T& combine )
+			{
+				Task< VALUE_T > pending[ MAXIMUM_SPLITS ];
+				unsigned int amountPending = 0;
+				while( end - begin > grain )
+				{
+					std::size_t middle = begin + ( end - begin ) / 2;
+					pending[ amountPending++ ] = ThreadItTask( [ middle, end, grain, &identity, &body, &combine ]() {
+							return ParallelReduceSplit( middle, end, grain, identity, body, combine );
+						} );
+					end = middle;
+				}
+				VALUE_T partial = identity;
+				for( std::size_t i = begin; i < end; ++i )
+					body( partial, i );
+				while( amountPending > 0 )
+					partial = combine( std::move( partial ), std::move( pending[ --amountPending ].GetResult() ) );
+				return ( partial );
+			}
+		}
+		/*Calls "body( index )" for every index in range, in parallel on the worker pool. 
+		grain is the most indices one task runs, 0 picks one from the amount of workers. 
+		Returns once every index is done.*/
+		template< typename BODY_T >
+		void ParallelFor( IndexRange range, std::size_t grain, BODY_T body )
+		{
+			if( range.Size() == 0 )
+				return;
+			Implementation::ParallelForSplit( range.begin, range.end, Implementation::PickGrain( range, grain ), body );
+		}
+		/*Reduces every index in range in parallel. "body( partial, index )" folds an index 
+		into a partial that starts as identity, "combine( left, right )" merges two partials.*/
+		template< typename VALUE_T, typename BODY_T, typename COMBINE_T >
+		VALUE_T ParallelReduce( IndexRange range, const VALUE_T& identity, BODY_T body, COMBINE_T combine, std::size_t grain = 0 )
+		{
+			if( range.Size() == 0 )
+				return ( identity );
+			return ( Implementation::ParallelReduceSplit( range.begin, range.end, 
+					Implementation::PickGrain( range, grain ), identity, body, combine ) );
+		}
+	#endif
+}
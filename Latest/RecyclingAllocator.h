@@ -0,0 +1,222 @@
+/*
+Copyright (C) 2013 Christopher A. Greeley
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), 
+to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, 
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+#pragma once
+//Included by ThreadItAtomic.h once the platform is configured.//
+#include <atomic>
+#include <cstddef>
+#include <new>
+
+namespace LibThreadIt
+{
+	namespace Implementation
+	{
+		//Blocks each thread keeps per size, anything past it goes back to the heap.//
+		const unsigned int MAXIMUM_RECYCLED_BLOCKS = 256;
+		struct RecycledBlock {
+			RecycledBlock* next;
+		};
+		/*One per thread and size. Blocks freed on another thread are pushed on "returned" 
+		and taken back in one exchange when "head" runs dry, so a block always comes home 
+		to the thread that allocated it. The list lives on the heap and is deleted by 
+		whoever drops the last reference, the thread holds one and every block it has 
+		handed out holds one.*/
+		struct BlockFreeList
+		{
+			RecycledBlock* head;
+			unsigned int size;
+			std::atomic< RecycledBlock* > returned;
+			std::atomic< std::size_t > references;
+		};
+		//Put in front of every block so a free on any thread can find the list it belongs to.//
+		struct alignas( alignof( std::max_align_t ) ) BlockHeader {
+			BlockFreeList* owner;
+		};
+		//"returned" once the owning thread has exited, blocks freed after that go to the heap.//
+		inline RecycledBlock* ClosedReturnStack() {
+			return ( reinterpret_cast< RecycledBlock* >( alignof( RecycledBlock ) ) );
+		}
+		inline void* BlockOf( BlockHeader* header ) {
+			return ( header + 1 );
+		}
+		inline BlockHeader* HeaderOf( void* memory ) {
+			return ( static_cast< BlockHeader* >( memory ) - 1 );
+		}
+		inline void DropReferences( BlockFreeList* blocks, std::size_t amount )
+		{
+			if( amount != 0 && blocks->references.fetch_sub( amount, std::memory_order_acq_rel ) == amount )
+				delete blocks;
+		}
+		//Frees every block in a chain to the heap, returns how many there were.//
+		inline std::size_t FreeChain( RecycledBlock* block )
+		{
+			std::size_t amount = 0;
+			while( block != nullptr ) {
+				RecycledBlock* next = block->next;
+				::operator delete( HeaderOf( block ) );
+				block = next;
+				++amount;
+			}
+			return ( amount );
+		}
+		//Plain data, so it can still be looked at while the thread is exiting.//
+		struct LocalBlockList
+		{
+			BlockFreeList* blocks;
+			//Set once the thread's list has been closed, later blocks are not recycled.//
+			bool hasExited;
+		};
+		//Closes the thread's list when the thread exits.//
+		struct BlockReaper
+		{
+			LocalBlockList* local;
+			explicit BlockReaper( LocalBlockList* local_ ) : local( local_ ) {
+			}
+			~BlockReaper()
+			{
+				BlockFreeList* blocks = local->blocks;
+				local->blocks = nullptr;
+				local->hasExited = true;
+				std::size_t freed = FreeChain( blocks->head );
+				freed += FreeChain( blocks->returned.exchange( ClosedReturnStack(), std::memory_order_acquire ) );
+				DropReferences( blocks, freed + 1 );
+			}
+		};
+		//The calling thread's list, null once it has exited or where there is no thread local storage.//
+		template< std::size_t BLOCK_SIZE_T >
+		BlockFreeList* LocalBlocks()
+		{
+			#ifdef THREAD_IT_POSIX_PLATFORM
+				static thread_local LocalBlockList local;
+				if( local.blocks == nullptr && local.hasExited == false )
+				{
+					local.blocks = new BlockFreeList();
+					local.blocks->references.store( 1, std::memory_order_relaxed );
+					static thread_local BlockReaper reaper( &local );
+					( void ) reaper;
+				}
+				return ( local.blocks );
+			#else
+				//No thread local storage to keep a list in, every block comes from the heap.//
+				return ( nullptr );
+			#endif
+		}
+		template< std::size_t BLOCK_SIZE_T >
+		void* AllocateBlock()
+		{
+			BlockFreeList* blocks = LocalBlocks< BLOCK_SIZE_T >();
+			if( blocks != nullptr && blocks->head == nullptr && 
+					blocks->returned.load( std::memory_order_relaxed ) != nullptr )
+			{
+				//The returned chain is not counted, the excess goes back to the heap here.//
+				RecycledBlock* block = blocks->returned.exchange( nullptr, std::memory_order_acquire );
+				while( block != nullptr && blocks->size < MAXIMUM_RECYCLED_BLOCKS ) {
+					RecycledBlock* next = block->next;
+					block->next = blocks->head;
+					blocks->head = block;
+					++blocks->size;
+					block = next;
+				}
+				DropReferences( blocks, FreeChain( block ) );
+			}
+			if( blocks == nullptr || blocks->head == nullptr )
+			{
+				BlockHeader* header = static_cast< BlockHeader* >( ::operator new( sizeof( BlockHeader ) + BLOCK_SIZE_T ) );
+				header->owner = blocks;
+				if( blocks != nullptr )
+					blocks->references.fetch_add( 1, std::memory_order_relaxed );
+				return ( BlockOf( header ) );
+			}
+			RecycledBlock* block = blocks->head;
+			blocks->head = block->next;
+			--blocks->size;
+			return ( block );
+		}
+		template< std::size_t BLOCK_SIZE_T >
+		void FreeBlock( void* memory )
+		{
+			BlockHeader* header = HeaderOf( memory );
+			BlockFreeList* owner = header->owner;
+			if( owner == nullptr ) {
+				::operator delete( header );
+				return;
+			}
+			RecycledBlock* block = static_cast< RecycledBlock* >( memory );
+			if( owner == LocalBlocks< BLOCK_SIZE_T >() )
+			{
+				if( owner->size == MAXIMUM_RECYCLED_BLOCKS ) {
+					::operator delete( header );
+					DropReferences( owner, 1 );
+					return;
+				}
+				block->next = owner->head;
+				owner->head = block;
+				++owner->size;
+				return;
+			}
+			RecycledBlock* returned = owner->returned.load( std::memory_order_relaxed );
+			do
+			{
+				if( returned == ClosedReturnStack() ) {
+					::operator delete( header );
+					DropReferences( owner, 1 );
+					return;
+				}
+				block->next = returned;
+			} while( owner->returned.compare_exchange_weak( returned, block, 
+					std::memory_order_release, std::memory_order_relaxed ) == false );
+		}
+		/*For std::allocate_shared. Single objects come from a free list on the calling 
+		thread, one list per size rounded up to 16 bytes. A block freed on another thread 
+		is handed back to the list it came from, so a thread that only launches detached 
+		work still gets its blocks back from the workers that free them.*/
+		template< typename TYPE_T >
+		struct RecyclingAllocator
+		{
+			typedef TYPE_T value_type;
+			static const std::size_t BLOCK_SIZE = ( ( sizeof( TYPE_T ) + 15 ) / 16 ) * 16;
+			static const bool IS_RECYCLED = ( alignof( TYPE_T ) <= alignof( std::max_align_t ) && 
+					sizeof( TYPE_T ) >= sizeof( RecycledBlock ) );
+			explicit RecyclingAllocator() {
+			}
+			template< typename OTHER_T >
+			RecyclingAllocator( const RecyclingAllocator< OTHER_T >& ) {
+			}
+			TYPE_T* allocate( std::size_t amount )
+			{
+				if( amount != 1 || IS_RECYCLED == false )
+					return static_cast< TYPE_T* >( ::operator new( amount * sizeof( TYPE_T ) ) );
+				return static_cast< TYPE_T* >( AllocateBlock< BLOCK_SIZE >() );
+			}
+			void deallocate( TYPE_T* memory, std::size_t amount )
+			{
+				if( amount != 1 || IS_RECYCLED == false )
+					::operator delete( memory );
+				else
+					FreeBlock< BLOCK_SIZE >( memory );
+			}
+			template< typename OTHER_T >
+			bool operator==( const RecyclingAllocator< OTHER_T >& ) const {
+				return ( true );
+			}
+			template< typename OTHER_T >
+			bool operator!=( const RecyclingAllocator< OTHER_T >& ) const {
+				return ( false );
+			}
+		};
+		template< typename TYPE_T, typename... ARGUMENTS_T >
+		std::shared_ptr< TYPE_T > MakeRecycled( ARGUMENTS_T&&... arguments ) {
+			return std::allocate_shared< TYPE_T >( RecyclingAllocator< TYPE_T >(), std::forward< ARGUMENTS_T >( arguments )... );
+		}
+	}
+}
@@ -0,0 +1,70 @@
+/*
+Copyright (C) 2013 Christopher A. Greeley
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), 
+to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, 
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+#include <Task.h>
+
+namespace LibThreadIt
+{
+	#ifdef THREAD_IT_POSIX_PLATFORM
+		namespace Implementation
+		{
+			namespace
+			{
+				const std::size_t TASK_NODE_BLOCK_SIZE = ( ( sizeof( TaskNode ) + 15 ) / 16 ) * 16;
+			}
+			TaskNode* AllocateTaskNode()
+			{
+				TaskNode* node = new( AllocateBlock< TASK_NODE_BLOCK_SIZE >() ) TaskNode();
+				//The handle and the pool.//
+				node->references.store( 2, std::memory_order_relaxed );
+				node->isDone.store( TASK_RUNNING, std::memory_order_relaxed );
+				return node;
+			}
+			void TaskNode::RunOnWorker()
+			{
+				invoke( payload );
+				if( isDone.exchange( TASK_DONE, std::memory_order_acq_rel ) == TASK_JOINED )
+					WakeAddress( &isDone, true );
+				RemoveReference();
+			}
+			void TaskNode::RemoveReference()
+			{
+				if( references.fetch_sub( 1, std::memory_order_acq_rel ) != 1 )
+					return;
+				destroy( payload, isInline );
+				//Back to the thread that launched it, even when a worker drops the last reference.//
+				this->~TaskNode();
+				FreeBlock< TASK_NODE_BLOCK_SIZE >( this );
+			}
+			void TaskNode::Wait()
+			{
+				WorkerPool& pool = WorkerPool::Global();
+				while( isDone.load( std::memory_order_acquire ) != TASK_DONE )
+				{
+					if( pool.IsWorkerThread() == true ) {
+						if( pool.RunPendingTask() == false )
+							std::this_thread::yield();
+					}
+					else
+					{
+						//Announce ourselves, so RunOnWorker knows to wake us.//
+						std::uint32_t running = TASK_RUNNING;
+						if( isDone.compare_exchange_strong( running, TASK_JOINED, 
+								std::memory_order_relaxed ) == true || running == TASK_JOINED )
+							ParkOnAddress( &isDone, TASK_JOINED );
+					}
+				}
+			}
+		}
+	#endif
+}
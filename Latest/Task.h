@@ -0,0 +1,210 @@
+/*
+Copyright (C) 2013 Christopher A. Greeley
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), 
+to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, 
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+#pragma once
+#include <WorkerPool.h>
+#include <cstddef>
+#include <tuple>
+#include <type_traits>
+
+namespace LibThreadIt
+{
+	#ifdef THREAD_IT_POSIX_PLATFORM
+		namespace Implementation
+		{
+			//Bytes for a task's callable, arguments and result before it spills to the heap.//
+			const std::size_t TASK_INLINE_CAPACITY = 128;
+			//What "TaskNode::isDone" holds.//
+			const std::uint32_t TASK_RUNNING = 0;
+			const std::uint32_t TASK_DONE = 1;
+			//Still running, and a joiner is parked on it, only then does the worker wake anyone.//
+			const std::uint32_t TASK_JOINED = 2;
+			template< std::size_t... INDICES_T >
+			struct IndexSequence {
+			};
+			template< std::size_t COUNT_T, std::size_t... INDICES_T >
+			struct MakeIndexSequence : MakeIndexSequence< COUNT_T - 1, COUNT_T - 1, INDICES_T... > {
+			};
+			template< std::size_t... INDICES_T >
+			struct MakeIndexSequence< 0, INDICES_T... > {
+				typedef IndexSequence< INDICES_T... > Type;
+			};
+			//Room for a result that may not be default constructible.//
+			template< typename RESULT_T >
+			struct TaskResultSlot
+			{
+				typename std::aligned_storage< sizeof( RESULT_T ), alignof( RESULT_T ) >::type storage;
+				bool hasValue;
+				explicit TaskResultSlot() : hasValue( false ) {
+				}
+				~TaskResultSlot() {
+					if( hasValue == true )
+						Get().~RESULT_T();
+				}
+				template< typename FUNCTION_T, typename TUPLE_T, std::size_t... INDICES_T >
+				void Run( FUNCTION_T& function, TUPLE_T& arguments, IndexSequence< INDICES_T... > ) {
+					new( &storage ) RESULT_T( function( std::move( std::get< INDICES_T >( arguments ) )... ) );
+					hasValue = true;
+				}
+				RESULT_T& Get() {
+					return *reinterpret_cast< RESULT_T* >( &storage );
+				}
+			};
+			template<>
+			struct TaskResultSlot< void >
+			{
+				template< typename FUNCTION_T, typename TUPLE_T, std::size_t... INDICES_T >
+				void Run( FUNCTION_T& function, TUPLE_T& arguments, IndexSequence< INDICES_T... > ) {
+					function( std::move( std::get< INDICES_T >( arguments ) )... );
+				}
+				void Get() {
+				}
+			};
+			//The callable, its arguments and its result, all in one block.//
+			template< typename FUNCTION_T, typename RESULT_T, typename... ARGUMENTS_T >
+			struct TaskPayload
+			{
+				FUNCTION_T function;
+				std::tuple< ARGUMENTS_T... > arguments;
+				TaskResultSlot< RESULT_T > result;
+				template< typename CALLABLE_T, typename... PASSED_T >
+				explicit TaskPayload( CALLABLE_T&& function_, PASSED_T&&... arguments_ ) : 
+						function( std::forward< CALLABLE_T >( function_ ) ), 
+						arguments( std::forward< PASSED_T >( arguments_ )... ) {
+				}
+				static void Invoke( void* payload )
+				{
+					TaskPayload* self = static_cast< TaskPayload* >( payload );
+					self->result.Run( self->function, self->arguments, 
+							typename MakeIndexSequence< sizeof...( ARGUMENTS_T ) >::Type() );
+				}
+				static void Destroy( void* payload, bool isInline )
+				{
+					TaskPayload* self = static_cast< TaskPayload* >( payload );
+					if( isInline == true )
+						self->~TaskPayload();
+					else
+						delete self;
+				}
+			};
+			template< typename PAYLOAD_T >
+			struct TaskFitsInline : std::integral_constant< bool, ( sizeof( PAYLOAD_T ) <= TASK_INLINE_CAPACITY && 
+					alignof( PAYLOAD_T ) <= alignof( std::max_align_t ) ) > {
+			};
+			/*What the pool runs for ThreadItTask. Nodes come from the launching thread's 
+			block list and go back to it from whichever thread frees them, and small payloads 
+			live inside the node, so launching a small task does not touch the global 
+			allocator once the list is warm, even from a thread outside the pool.*/
+			struct TaskNode : public PoolTask
+			{
+				//One for each Task handle, plus one while it is queued or running.//
+				std::atomic< unsigned int > references;
+				std::atomic< std::uint32_t > isDone;
+				void* payload;
+				bool isInline;
+				void (* invoke )( void* );
+				void (* destroy )( void*, bool );
+				//Where the result is, inside the payload.//
+				void* result;
+				std::aligned_storage< TASK_INLINE_CAPACITY, alignof( std::max_align_t ) >::type storage;
+				virtual void RunOnWorker();
+				template< typename PAYLOAD_T, typename... PASSED_T >
+				PAYLOAD_T* MakePayload( std::true_type, PASSED_T&&... passed ) {
+					return new( &storage ) PAYLOAD_T( std::forward< PASSED_T >( passed )... );
+				}
+				template< typename PAYLOAD_T, typename... PASSED_T >
+				PAYLOAD_T* MakePayload( std::false_type, PASSED_T&&... passed ) {
+					return new PAYLOAD_T( std::forward< PASSED_T >( passed )... );
+				}
+				void AddReference() {
+					references.fetch_add( 1, std::memory_order_relaxed );
+				}
+				void RemoveReference();
+				void Wait();
+				template< typename FUNCTION_T, typename RESULT_T, typename... ARGUMENTS_T, typename CALLABLE_T, typename... PASSED_T >
+				void Emplace( CALLABLE_T&& function, PASSED_T&&... arguments )
+				{
+					typedef TaskPayload< FUNCTION_T, RESULT_T, ARGUMENTS_T... > PAYLOAD_T;
+					isInline = TaskFitsInline< PAYLOAD_T >::value;
+					PAYLOAD_T* made = MakePayload< PAYLOAD_T >( std::integral_constant< bool, TaskFitsInline< PAYLOAD_T >::value >(), 
+							std::forward< CALLABLE_T >( function ), std::forward< PASSED_T >( arguments )... );
+					payload = made;
+					result = &made->result;
+					invoke = &PAYLOAD_T::Invoke;
+					destroy = &PAYLOAD_T::Destroy;
+				}
+			};
+			//From the calling thread's block list, or the heap if it is empty.//
+			TaskNode* AllocateTaskNode();
+		}
+		//A handle to a task launched with ThreadItTask, copies share the task.//
+		template< typename RESULT_T >
+		class Task
+		{
+			Implementation::TaskNode* node;
+			public: 
+				explicit Task() : node( nullptr ) {
+				}
+				explicit Task( Implementation::TaskNode* node_ ) : node( node_ ) {
+				}
+				Task( const Task& other ) : node( other.node ) {
+					if( node != nullptr )
+						node->AddReference();
+				}
+				Task( Task&& other ) : node( other.node ) {
+					other.node = nullptr;
+				}
+				Task& operator=( Task other ) {
+					std::swap( node, other.node );
+					return *this;
+				}
+				~Task() {
+					if( node != nullptr )
+						node->RemoveReference();
+				}
+				//A default constructed Task has nothing behind it.//
+				bool IsValid() {
+					return ( node != nullptr );
+				}
+				//Nothing is left to run on an invalid Task, so it counts as done.//
+				bool IsDone() {
+					return ( node == nullptr || node->isDone.load( std::memory_order_acquire ) == Implementation::TASK_DONE );
+				}
+				//Workers help run other tasks while they wait.//
+				void Join() {
+					if( node != nullptr )
+						node->Wait();
+				}
+				//Waits if need be, the result lives as long as the task does. The Task has to be valid.//
+				typename std::add_lvalue_reference< RESULT_T >::type GetResult() {
+					Join();
+					return static_cast< Implementation::TaskResultSlot< RESULT_T >* >( node->result )->Get();
+				}
+		};
+		/*Runs "function( arguments... )" on the worker pool. Anything callable works, 
+		lambdas included, and arguments are moved in so move only types are fine.*/
+		template< typename FUNCTION_T, typename... ARGUMENTS_T >
+		auto ThreadItTask( FUNCTION_T&& function, ARGUMENTS_T&&... arguments ) -> 
+				Task< decltype( std::declval< typename std::decay< FUNCTION_T >::type& >()( 
+						std::declval< typename std::decay< ARGUMENTS_T >::type >()... ) ) >
+		{
+			typedef typename std::decay< FUNCTION_T >::type CALLABLE_T;
+			typedef decltype( std::declval< CALLABLE_T& >()( std::declval< typename std::decay< ARGUMENTS_T >::type >()... ) ) RESULT_T;
+			Implementation::TaskNode* node = Implementation::AllocateTaskNode();
+			node->Emplace< CALLABLE_T, RESULT_T, typename std::decay< ARGUMENTS_T >::type... >( 
+					std::forward< FUNCTION_T >( function ), std::forward< ARGUMENTS_T >( arguments )... );
+			Implementation::WorkerPool::Global().Submit( node );
+			return Task< RESULT_T >( node );
+		}
+	#endif
+}
@@ -0,0 +1,143 @@
+/*
+Copyright (C) 2013 Christopher A. Greeley
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), 
+to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, 
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+#include <TestSupport.h>
+
+//AquireAll and ReleaseAll on an AtomicManager, from one thread and across threads.//
+namespace ThreadItTests
+{
+	namespace
+	{
+		int sharedCount = 0;
+		std::atomic< int > amountInside( 0 );
+		std::atomic< int > mostInside( 0 );
+		void IncrementShared( ATOMIC_RESOURCE pool )
+		{
+			for( int i = 0; i < 2000; ++i )
+			{
+				auto atomic = LibThreadIt::MakeAtomic( pool, &sharedCount );
+				int* count = *atomic;
+				const int INSIDE = amountInside.fetch_add( 1 ) + 1;
+				int most = mostInside.load();
+				while( INSIDE > most && mostInside.compare_exchange_weak( most, INSIDE ) == false );
+				++( *count );
+				std::this_thread::yield();
+				amountInside.fetch_sub( 1 );
+			}
+		}
+	}
+	/*Siblings holding a pool that was empty when they started, the Atomic they 
+	branch is not covered by their holds and has to lock.*/
+	void TestAquireAllOnStartExcludes()
+	{
+		ATOMIC_RESOURCE pool = LibThreadIt::MakeAtomicResource();
+		std::vector< THREAD_HANDLE > handles;
+		for( unsigned int i = 0; i < 4; ++i )
+			handles.push_back( LibThreadIt::ThreadItInitializeWithPool( pool, LibThreadIt::AQUIRE_ALL_ON_START, 
+					LibThreadIt::JOIN, &IncrementShared, pool ) );
+		for( unsigned int i = 0; i < handles.size(); ++i )
+			handles[ i ]->Join();
+		Check( sharedCount == 8000, "AQUIRE_ALL_ON_START siblings lose no increments" );
+		Check( mostInside.load() == 1, "AQUIRE_ALL_ON_START siblings exclude each other" );
+		//Once the pool has the atomic, a hold that took it covers it.//
+		LibThreadIt::PoolHold hold = pool->Hold();
+		LibThreadIt::Implementation::HeldOnThisThread covered( &hold );
+		auto atomic = LibThreadIt::MakeAtomic( pool, &sharedCount );
+		Check( atomic.isCovered == true, "An Atomic whose lock word the hold took is covered" );
+		int other = 0;
+		auto later = LibThreadIt::MakeAtomic( pool, &other );
+		Check( later.isCovered == false, "An Atomic branched after the hold is not covered" );
+	}
+	//AquireAll and ReleaseAll pair up on the calling thread, nested ones only count.//
+	void TestAquireAllPairsPerThread()
+	{
+		int data = 0;
+		ATOMIC_RESOURCE pool = LibThreadIt::MakeAtomicResource();
+		pool->Branch( &data );
+		pool->AquireAll();
+		pool->AquireAll();
+		pool->ReleaseAll();
+		bool isTaken = true;
+		std::thread( [ &pool, &isTaken ]() { isTaken = pool->TryAquireAll(); } ).join();
+		Check( isTaken == false, "A nested ReleaseAll keeps the outer hold" );
+		pool->ReleaseAll();
+		std::thread( [ &pool, &isTaken ]() {
+				isTaken = pool->TryAquireAll();
+				if( isTaken == true )
+					pool->ReleaseAll();
+			} ).join();
+		Check( isTaken == true, "The last ReleaseAll gives the pool back" );
+	}
+	//A manager aquired on one thread can be released on another, in either direction.//
+	void TestReleaseAllOnAnotherThread()
+	{
+		int data = 0;
+		ATOMIC_RESOURCE pool = LibThreadIt::MakeAtomicResource();
+		pool->Branch( &data );
+		bool isTaken = false;
+		auto tryPool = [ &pool, &isTaken ]() {
+				isTaken = pool->TryAquireAll();
+				if( isTaken == true )
+					pool->ReleaseAll();
+			};
+		pool->AquireAll();
+		std::thread( [ &pool ]() { pool->ReleaseAll(); } ).join();
+		std::thread( tryPool ).join();
+		Check( isTaken == true, "ReleaseAll on another thread gives the pool back" );
+		Check( pool->Branch( &data ).isCovered == false, "A hold released on another thread no longer covers" );
+		std::atomic< bool > isAquired( false );
+		std::atomic< bool > mayExit( false );
+		std::thread aquirer( [ &pool, &isAquired, &mayExit ]() {
+				pool->AquireAll();
+				isAquired.store( true, std::memory_order_release );
+				WaitForGate( &mayExit );
+			} );
+		WaitForGate( &isAquired );
+		Check( pool->TryAquireAll() == false, "A manager held on another thread can not be taken" );
+		pool->ReleaseAll();
+		Check( pool->TryAquireAll() == true, "ReleaseAll gives back a hold taken on a thread that still runs" );
+		pool->ReleaseAll();
+		mayExit.store( true, std::memory_order_release );
+		aquirer.join();
+		std::thread( tryPool ).join();
+		Check( isTaken == true, "A thread whose hold was released for it exits without releasing again" );
+		pool->ReleaseAll();
+		std::thread( tryPool ).join();
+		Check( isTaken == true, "ReleaseAll with nothing held does nothing" );
+	}
+	//Once warm, AquireAll and TryAquireAll reuse the thread's released holds and their storage.//
+	void TestAquireAllReusesHolds()
+	{
+		std::vector< int > data( 64 );
+		ATOMIC_RESOURCE pool = LibThreadIt::MakeAtomicResource();
+		for( unsigned int i = 0; i < data.size(); ++i )
+			pool->Branch( &data[ i ] );
+		pool->AquireAll();
+		pool->AquireAll();
+		pool->ReleaseAll();
+		pool->ReleaseAll();
+		const unsigned int ALLOCATIONS = amountOfAllocations.load();
+		isCountingAllocations = true;
+		for( unsigned int i = 0; i < 100; ++i )
+		{
+			pool->AquireAll();
+			pool->AquireAll();
+			pool->ReleaseAll();
+			pool->ReleaseAll();
+			if( pool->TryAquireAll() == true )
+				pool->ReleaseAll();
+		}
+		isCountingAllocations = false;
+		Check( amountOfAllocations.load() == ALLOCATIONS, "AquireAll and ReleaseAll do not allocate once warm" );
+	}
+}
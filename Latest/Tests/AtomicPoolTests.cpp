@@ -0,0 +1,86 @@
+/*
+Copyright (C) 2013 Christopher A. Greeley
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), 
+to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, 
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+#include <TestSupport.h>
+
+//AtomicPools over the same objects, listed in different orders.//
+namespace ThreadItTests
+{
+	/*Two pools list the same objects in opposite order, threads aquiring one or the 
+	other must neither deadlock nor both get in.*/
+	void TestAtomicPoolsInOppositeOrder()
+	{
+		const unsigned int ROUNDS = 20000;
+		int first = 0;
+		int second = 0;
+		double third = 0;
+		LibThreadIt::AtomicPool< int, int, double > forward( &first, &second, &third );
+		LibThreadIt::AtomicPool< double, int, int > backward( &third, &second, &first );
+		std::atomic< int > amountInside( 0 );
+		std::atomic< unsigned int > amountOverlapping( 0 );
+		std::atomic< unsigned int > amountFinished( 0 );
+		std::vector< std::thread > threads;
+		for( unsigned int i = 0; i < 4; ++i )
+		{
+			threads.push_back( std::thread( [ &, i ]() {
+					for( unsigned int j = 0; j < ROUNDS; ++j )
+					{
+						if( i % 2 == 0 )
+						{
+							auto held = forward.Aquire();
+							if( amountInside.fetch_add( 1 ) != 0 )
+								amountOverlapping.fetch_add( 1 );
+							++held.Get< 0 >();
+							++held.Get< 1 >();
+							held.Get< 2 >() += 1;
+							amountInside.fetch_sub( 1 );
+						}
+						else
+						{
+							auto held = backward.Aquire();
+							if( amountInside.fetch_add( 1 ) != 0 )
+								amountOverlapping.fetch_add( 1 );
+							held.Get< 0 >() += 1;
+							++held.Get< 1 >();
+							++held.Get< 2 >();
+							amountInside.fetch_sub( 1 );
+						}
+					}
+					amountFinished.fetch_add( 1, std::memory_order_release );
+				} ) );
+		}
+		for( int i = 0; i < 30000 && amountFinished.load( std::memory_order_acquire ) != threads.size(); ++i )
+			Sleep( 1 );
+		const bool IS_FINISHED = ( amountFinished.load( std::memory_order_acquire ) == threads.size() );
+		Check( IS_FINISHED == true, "AtomicPools listing the same objects in opposite order do not deadlock" );
+		for( unsigned int i = 0; i < threads.size(); ++i )
+		{
+			//Left stuck on a failure, so the other tests still run.//
+			if( IS_FINISHED == true )
+				threads[ i ].join();
+			else
+				threads[ i ].detach();
+		}
+		if( IS_FINISHED == false )
+			return;
+		Check( amountOverlapping.load() == 0, "AtomicPools on the same objects exclude each other" );
+		Check( first == int( 4 * ROUNDS ) && second == int( 4 * ROUNDS ) && third == 4.0 * ROUNDS, 
+				"AtomicPools on the same objects lose no increments" );
+		LibThreadIt::AtomicPool< int, int > twice( &first, &first );
+		Check( twice.TryAquireAll() == true, "A pool listing one object twice aquires it once" );
+		Check( forward.TryAquireAll() == false, "A pool sharing a held object can not be taken" );
+		twice.ReleaseAll();
+		Check( forward.TryAquireAll() == true, "A released pool can be taken" );
+		forward.ReleaseAll();
+	}
+}
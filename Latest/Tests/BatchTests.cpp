@@ -0,0 +1,39 @@
+/*
+Copyright (C) 2013 Christopher A. Greeley
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), 
+to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, 
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+#include <TestSupport.h>
+
+//Batches of tasks on the worker pool.//
+namespace ThreadItTests
+{
+	namespace
+	{
+		int SlowDouble( int value ) {
+			Sleep( 20 );
+			return value * 2;
+		}
+	}
+	//Joining a batch from outside the pool parks until its last task finishes.//
+	void TestBatchJoin()
+	{
+		std::vector< int > arguments( 4, 1 );
+		std::atomic< int > total( 0 );
+		LibThreadIt::BatchHandle batch = LibThreadIt::ThreadItBatch( nullptr, [ &total ]( int value ) {
+				total.fetch_add( SlowDouble( value ) );
+			}, arguments );
+		batch.JoinAll();
+		Check( batch.IsComplete() == true && total.load() == 8, "BatchHandle::JoinAll wakes after the last task" );
+		Check( LibThreadIt::ThreadItBatch( nullptr, &SlowDouble, std::vector< int >() ).IsComplete() == true, 
+				"An empty batch is complete right away" );
+	}
+}
@@ -0,0 +1,138 @@
+/*
+Copyright (C) 2013 Christopher A. Greeley
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), 
+to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, 
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+#include <TestSupport.h>
+#include <memory>
+
+//Channels with many threads on each end, full, empty and closed.//
+namespace ThreadItTests
+{
+	/*Producers push distinct values, some one at a time and some in runs, into a 
+	channel much smaller than all of them. Every value has to come out exactly once.*/
+	void TestChannelExactlyOnce()
+	{
+		const unsigned int AMOUNT_OF_PRODUCERS = 4;
+		const unsigned int AMOUNT_OF_CONSUMERS = 4;
+		const unsigned int VALUES_EACH = 20000;
+		LibThreadIt::Channel< unsigned int > channel( 64 );
+		std::unique_ptr< std::atomic< unsigned int >[] > seen( new std::atomic< unsigned int >[ AMOUNT_OF_PRODUCERS * VALUES_EACH ] );
+		for( unsigned int i = 0; i < AMOUNT_OF_PRODUCERS * VALUES_EACH; ++i )
+			seen[ i ].store( 0 );
+		std::vector< std::thread > producers;
+		for( unsigned int i = 0; i < AMOUNT_OF_PRODUCERS; ++i )
+		{
+			producers.push_back( std::thread( [ &channel, i ]() {
+					unsigned int run[ 7 ];
+					for( unsigned int value = i * VALUES_EACH; value < ( i + 1 ) * VALUES_EACH; )
+					{
+						if( i % 2 == 0 || ( i + 1 ) * VALUES_EACH - value < 7 )
+							channel.Push( value++ );
+						else
+						{
+							for( unsigned int j = 0; j < 7; ++j )
+								run[ j ] = value + j;
+							channel.PushN( run, 7 );
+							value += 7;
+						}
+					}
+				} ) );
+		}
+		std::vector< std::thread > consumers;
+		for( unsigned int i = 0; i < AMOUNT_OF_CONSUMERS; ++i )
+		{
+			consumers.push_back( std::thread( [ &channel, &seen, i ]() {
+					unsigned int run[ 5 ];
+					while( true )
+					{
+						std::size_t popped = ( i % 2 == 0 ) ? channel.PopN( run, 5 ) : 
+								( ( channel.Pop( run[ 0 ] ) == true ) ? 1 : 0 );
+						if( popped == 0 )
+							return;
+						for( std::size_t j = 0; j < popped; ++j )
+							seen[ run[ j ] ].fetch_add( 1, std::memory_order_relaxed );
+					}
+				} ) );
+		}
+		for( unsigned int i = 0; i < AMOUNT_OF_PRODUCERS; ++i )
+			producers[ i ].join();
+		channel.Close();
+		for( unsigned int i = 0; i < AMOUNT_OF_CONSUMERS; ++i )
+			consumers[ i ].join();
+		unsigned int amountWrong = 0;
+		for( unsigned int i = 0; i < AMOUNT_OF_PRODUCERS * VALUES_EACH; ++i )
+			if( seen[ i ].load() != 1 )
+				++amountWrong;
+		Check( amountWrong == 0, "Every value pushed into a Channel is popped exactly once" );
+	}
+	//Push waits while the channel is full and Pop while it is empty, until the other end moves.//
+	void TestChannelBlocks()
+	{
+		LibThreadIt::Channel< int > channel( 2 );
+		Check( channel.TryPush( 1 ) == true && channel.TryPush( 2 ) == true && channel.TryPush( 3 ) == false, 
+				"TryPush fails on a full Channel" );
+		std::atomic< bool > isPushed( false );
+		std::thread pusher( [ &channel, &isPushed ]() {
+				channel.Push( 3 );
+				isPushed.store( true, std::memory_order_release );
+			} );
+		Sleep( 20 );
+		Check( isPushed.load() == false, "Push waits while the Channel is full" );
+		int value = 0;
+		channel.Pop( value );
+		pusher.join();
+		Check( value == 1 && isPushed.load() == true, "Push goes through once a Pop makes room" );
+		channel.Pop( value );
+		channel.Pop( value );
+		Check( value == 3 && channel.TryPop( value ) == false, "TryPop fails on an empty Channel" );
+		std::atomic< bool > isPopped( false );
+		std::thread popper( [ &channel, &isPopped, &value ]() {
+				channel.Pop( value );
+				isPopped.store( true, std::memory_order_release );
+			} );
+		Sleep( 20 );
+		Check( isPopped.load() == false, "Pop waits while the Channel is empty" );
+		channel.Push( 4 );
+		popper.join();
+		Check( value == 4 && isPopped.load() == true, "Pop goes through once a Push brings data" );
+	}
+	//What was pushed before Close still comes out, then pops fail, and nothing parked stays parked.//
+	void TestChannelCloseDrains()
+	{
+		LibThreadIt::Channel< int > channel( 8 );
+		for( int i = 0; i < 3; ++i )
+			channel.Push( i );
+		channel.Close();
+		Check( channel.Push( 3 ) == false && channel.TryPush( 3 ) == false, "Pushes fail on a closed Channel" );
+		int values[ 8 ] = { -1, -1, -1, -1, -1, -1, -1, -1 };
+		Check( channel.PopN( values, 8 ) == 3 && values[ 0 ] == 0 && values[ 1 ] == 1 && values[ 2 ] == 2, 
+				"A closed Channel gives up what was pushed before Close" );
+		Check( channel.Pop( values[ 0 ] ) == false, "Pop fails on a closed and drained Channel" );
+		LibThreadIt::Channel< int > empty( 2 );
+		bool isPopped = true;
+		std::thread popper( [ &empty, &isPopped ]() {
+				int value;
+				isPopped = empty.Pop( value );
+			} );
+		LibThreadIt::Channel< int > full( 2 );
+		full.Push( 0 );
+		full.Push( 1 );
+		bool isPushed = true;
+		std::thread pusher( [ &full, &isPushed ]() { isPushed = full.Push( 2 ); } );
+		Sleep( 20 );
+		empty.Close();
+		full.Close();
+		popper.join();
+		pusher.join();
+		Check( isPopped == false && isPushed == false, "Close wakes threads parked on the Channel" );
+	}
+}
@@ -0,0 +1,71 @@
+/*
+Copyright (C) 2013 Christopher A. Greeley
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), 
+to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, 
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+#include <TestSupport.h>
+
+//What the ContentionProfiler counts, summed over threads and ranked.//
+namespace ThreadItTests
+{
+	namespace
+	{
+		//Only their addresses are used, waits recorded on them dwarf any real one.//
+		char hotLocks[ 3 ];
+		const std::uint64_t SECOND = 1000000000ull;
+		LibThreadIt::LockProfile ProfileOf( const void* address )
+		{
+			std::vector< LibThreadIt::LockProfile > profiles = LibThreadIt::ContentionProfiler::Snapshot();
+			for( std::size_t i = 0; i < profiles.size(); ++i )
+				if( profiles[ i ].address == address )
+					return profiles[ i ];
+			LibThreadIt::LockProfile none = {};
+			return none;
+		}
+	}
+	/*Hottest ranks by total wait summed over every thread, including threads that 
+	have exited, worst first.*/
+	void TestContentionProfilerHottest()
+	{
+		LibThreadIt::Implementation::RecordAquire( &hotLocks[ 0 ], "first", true, 1000 * SECOND );
+		std::thread( []() {
+				LibThreadIt::Implementation::RecordAquire( &hotLocks[ 0 ], "first", true, 2000 * SECOND );
+				LibThreadIt::Implementation::RecordAquire( &hotLocks[ 2 ], "third", true, 1000 * SECOND );
+			} ).join();
+		LibThreadIt::Implementation::RecordAquire( &hotLocks[ 1 ], "second", true, 5000 * SECOND );
+		LibThreadIt::Implementation::RecordAquire( &hotLocks[ 2 ], "third", false, 0 );
+		std::vector< LibThreadIt::LockProfile > hottest = LibThreadIt::ContentionProfiler::Hottest( 3 );
+		Check( hottest.size() == 3 && hottest[ 0 ].address == &hotLocks[ 1 ] && hottest[ 1 ].address == &hotLocks[ 0 ] && 
+				hottest[ 2 ].address == &hotLocks[ 2 ], "ContentionProfiler::Hottest ranks by total wait, worst first" );
+		Check( hottest.size() == 3 && hottest[ 1 ].totalWaitNanoseconds == 3000 * SECOND && hottest[ 1 ].aquires == 2 && 
+				hottest[ 1 ].maximumWaitNanoseconds == 2000 * SECOND, "A lock's profile sums its threads, exited ones included" );
+		Check( hottest.size() == 3 && hottest[ 2 ].aquires == 2 && hottest[ 2 ].contendedAquires == 1, 
+				"Only contended aquires count as contended" );
+		Check( LibThreadIt::ContentionProfiler::Hottest( 1 ).size() == 1, "Hottest gives at most the amount asked for" );
+		//A real wait on an Atomic, only counted while the profiler is on.//
+		int data = 0;
+		LibThreadIt::Atomic< int > held( &data );
+		held.Aquire();
+		LibThreadIt::ContentionProfiler::Enable();
+		std::thread waiter( [ &data ]() {
+				LibThreadIt::Atomic< int > waiting( &data );
+				++( *( *waiting ) );
+				waiting.Release();
+			} );
+		Sleep( 20 );
+		held.Release();
+		waiter.join();
+		LibThreadIt::ContentionProfiler::Disable();
+		LibThreadIt::LockProfile profile = ProfileOf( &data );
+		Check( profile.contendedAquires == 1 && profile.totalWaitNanoseconds >= 10000000ull, 
+				"An Atomic that waited is profiled as contended, with its wait" );
+	}
+}
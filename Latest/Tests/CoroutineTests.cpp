@@ -0,0 +1,97 @@
+/*
+Copyright (C) 2013 Christopher A. Greeley
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), 
+to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, 
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+#include <TestSupport.h>
+
+//Coroutines waiting on handles and Atomics, only built as C++20.//
+namespace ThreadItTests
+{
+	#if defined( __cpp_impl_coroutine )
+		namespace
+		{
+			LibThreadIt::ThreadItCoroutine IncrementAfter( THREAD_HANDLE handle, int* data, std::atomic< bool >* isFinished )
+			{
+				co_await handle;
+				LibThreadIt::Atomic< int > atomic( data );
+				++( *co_await atomic.AquireAsync() );
+				atomic.Release();
+				isFinished->store( true, std::memory_order_release );
+			}
+			//Reads, then keeps the read until "release" has run.//
+			LibThreadIt::ThreadItCoroutine ReadUntil( THREAD_HANDLE release, int* data, std::atomic< int >* amountReading, 
+					std::atomic< int >* amountFinished )
+			{
+				LibThreadIt::Atomic< int > atomic( data );
+				const int* value = co_await atomic.ReadAsync();
+				if( *value == 1 )
+					amountReading->fetch_add( 1, std::memory_order_release );
+				co_await release;
+				atomic.Release();
+				amountFinished->fetch_add( 1, std::memory_order_release );
+			}
+		}
+		//Built as C++20, a coroutine waits on a handle and an Atomic without holding a thread.//
+		void TestCoroutines()
+		{
+			int data = 0;
+			std::atomic< bool > gate( false );
+			std::atomic< bool > isFinished( false );
+			LibThreadIt::Atomic< int > held( &data );
+			held.Aquire();
+			THREAD_HANDLE handle = LibThreadIt::ThreadItInitialize( LibThreadIt::DO_NOT_AQUIRE_ALL_ON_START, 
+					LibThreadIt::JOIN, &WaitForGate, &gate );
+			IncrementAfter( handle, &data, &isFinished );
+			gate.store( true, std::memory_order_release );
+			handle->Join();
+			Sleep( 20 );
+			Check( isFinished.load() == false, "AquireAsync waits while the Atomic is held" );
+			held.Release();
+			for( int i = 0; i < 5000 && isFinished.load( std::memory_order_acquire ) == false; ++i )
+				Sleep( 1 );
+			Check( isFinished.load() == true && data == 1, "A coroutine resumes after the handle and the Atomic" );
+		}
+		//Coroutines waiting to read behind a writer are all handed the lock, shared, when it lets go.//
+		void TestCoroutineReadersShare()
+		{
+			int data = 0;
+			std::atomic< bool > gate( false );
+			std::atomic< int > amountReading( 0 );
+			std::atomic< int > amountFinished( 0 );
+			LibThreadIt::Atomic< int > held( &data );
+			held.Aquire();
+			THREAD_HANDLE release = LibThreadIt::ThreadItInitialize( LibThreadIt::DO_NOT_AQUIRE_ALL_ON_START, 
+					LibThreadIt::JOIN, &WaitForGate, &gate );
+			ReadUntil( release, &data, &amountReading, &amountFinished );
+			ReadUntil( release, &data, &amountReading, &amountFinished );
+			Sleep( 20 );
+			Check( amountReading.load() == 0, "ReadAsync waits while the Atomic is written" );
+			data = 1;
+			held.Release();
+			for( int i = 0; i < 5000 && amountReading.load( std::memory_order_acquire ) != 2; ++i )
+				Sleep( 1 );
+			Check( amountReading.load() == 2, "Coroutines waiting to read share the lock once the writer is done" );
+			bool isExcluded = false;
+			std::thread( [ &data, &isExcluded ]() {
+					LibThreadIt::Atomic< int > writer( &data );
+					isExcluded = ( writer.TryAtomicAquire() == false );
+				} ).join();
+			Check( isExcluded == true, "Coroutines reading an Atomic keep writers out" );
+			gate.store( true, std::memory_order_release );
+			release->Join();
+			for( int i = 0; i < 5000 && amountFinished.load( std::memory_order_acquire ) != 2; ++i )
+				Sleep( 1 );
+			Check( amountFinished.load() == 2 && held.TryAtomicAquire() == true, "Coroutine readers give the lock back" );
+			held.Release();
+		}
+	#endif
+}
@@ -0,0 +1,85 @@
+/*
+Copyright (C) 2013 Christopher A. Greeley
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), 
+to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, 
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+#include <TestSupport.h>
+#include <string>
+
+//Futures and Promises, set from one thread and read from others.//
+namespace ThreadItTests
+{
+	namespace
+	{
+		//Has no default constructor, a Future of it only constructs it once it is set.//
+		struct Unmakeable
+		{
+			int value;
+			explicit Unmakeable( int value_ ) : value( value_ ) {
+			}
+		};
+	}
+	//A Get from a thread outside the pool parks, the late SetValue has to wake it.//
+	void TestFutureWake()
+	{
+		LibThreadIt::Promise< int > promise;
+		LibThreadIt::Future< int > future = promise.GetFuture();
+		std::thread setter( [ promise ]() mutable {
+				Sleep( 20 );
+				promise.SetValue( 7 );
+			} );
+		Check( future.Get() == 7, "Future::Get returns the value set after it parked" );
+		setter.join();
+		Check( future.Then( []( int value ) { return value + 1; } ).Get() == 8, "Future::Then runs on a ready future" );
+		std::vector< LibThreadIt::Future< int > > futures;
+		std::vector< LibThreadIt::Promise< int > > promises( 3 );
+		for( unsigned int i = 0; i < 3; ++i )
+			futures.push_back( promises[ i ].GetFuture() );
+		LibThreadIt::Future< std::vector< int > > all = LibThreadIt::WhenAll( futures );
+		LibThreadIt::Future< std::size_t > any = LibThreadIt::WhenAny( futures );
+		promises[ 1 ].SetValue( 1 );
+		Check( any.Get() == 1, "WhenAny names the first future to finish" );
+		Check( all.IsReady() == false, "WhenAll waits for every future" );
+		promises[ 0 ].SetValue( 0 );
+		promises[ 2 ].SetValue( 2 );
+		std::vector< int > results = all.Get();
+		Check( results.size() == 3 && results[ 0 ] == 0 && results[ 1 ] == 1 && results[ 2 ] == 2, 
+				"WhenAll keeps the results in order" );
+		Check( LibThreadIt::WhenAny( std::vector< LibThreadIt::Future< int > >() ).Get() == 0, 
+				"WhenAny on no futures is ready right away" );
+	}
+	//Only the first SetValue counts, even when several race with each other and with readers.//
+	void TestFutureSetOnce()
+	{
+		Check( LibThreadIt::Future< int >().IsValid() == false, "A default constructed Future is not valid" );
+		LibThreadIt::Promise< Unmakeable > unmakeable;
+		Check( unmakeable.SetValue( Unmakeable( 3 ) ) == true && unmakeable.GetFuture().Get().value == 3, 
+				"A Future of a type without a default constructor" );
+		for( unsigned int round = 0; round < 100; ++round )
+		{
+			LibThreadIt::Promise< std::string > promise;
+			LibThreadIt::Future< std::string > future = promise.GetFuture();
+			std::atomic< unsigned int > amountSet( 0 );
+			std::vector< std::thread > setters;
+			for( unsigned int i = 0; i < 4; ++i )
+				setters.push_back( std::thread( [ promise, i, &amountSet ]() mutable {
+						if( promise.SetValue( std::string( 64, static_cast< char >( 'a' + i ) ) ) == true )
+							amountSet.fetch_add( 1 );
+					} ) );
+			const std::string VALUE = future.Get();
+			for( unsigned int i = 0; i < setters.size(); ++i )
+				setters[ i ].join();
+			Check( amountSet.load() == 1, "Exactly one racing SetValue wins" );
+			Check( VALUE.size() == 64 && VALUE == std::string( 64, VALUE[ 0 ] ) && future.Get() == VALUE, 
+					"Readers only see the winning value, whole" );
+		}
+	}
+}
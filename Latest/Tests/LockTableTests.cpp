@@ -0,0 +1,92 @@
+/*
+Copyright (C) 2013 Christopher A. Greeley
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), 
+to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, 
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+#include <TestSupport.h>
+#include <memory>
+
+//Lock words in the LockTable, reused while copied Atomics still point at them.//
+namespace ThreadItTests
+{
+	/*A copy outliving its pool still finds its lock word, even after enough other 
+	objects were locked for the table to hand its block to another one.*/
+	void TestCopiedAtomicOutlivesPool()
+	{
+		int data = 0;
+		std::vector< int > others( 100000 );
+		LibThreadIt::Atomic< int > copied = LibThreadIt::MakeAtomic( LibThreadIt::MakeAtomicResource(), &data );
+		LibThreadIt::Atomic< int > assigned;
+		{
+			ATOMIC_RESOURCE pool = LibThreadIt::MakeAtomicResource();
+			assigned = pool->Branch( &data );
+		}
+		for( unsigned int i = 0; i < others.size(); ++i ) {
+			LibThreadIt::Atomic< int > shortLived( &others[ i ] );
+			shortLived.Aquire();
+		}
+		++( *( *copied ) );
+		copied.Release();
+		++( *( *assigned ) );
+		bool isExcluded = true;
+		std::thread( [ &data, &isExcluded ]() {
+				LibThreadIt::Atomic< int > fresh( &data );
+				isExcluded = ( fresh.TryAtomicAquire() == false );
+			} ).join();
+		assigned.Release();
+		Check( data == 2, "Copied Atomics still work after their pools are gone" );
+		Check( isExcluded == true, "A copy that outlived its pool still excludes new Atomics on the data" );
+	}
+	/*Threads locking far more objects than the table has blocks, through copies whose 
+	lock words keep going stale. Each object still has one holder at a time.*/
+	void TestLockWordsAreReused()
+	{
+		const unsigned int AMOUNT_OF_OBJECTS = 1 << 14;
+		const unsigned int AMOUNT_OF_THREADS = 8;
+		const unsigned int ROUNDS = 20000;
+		std::vector< int > counts( AMOUNT_OF_OBJECTS, 0 );
+		std::unique_ptr< std::atomic< int >[] > inside( new std::atomic< int >[ AMOUNT_OF_OBJECTS ] );
+		for( unsigned int i = 0; i < AMOUNT_OF_OBJECTS; ++i )
+			inside[ i ].store( 0 );
+		std::vector< LibThreadIt::Atomic< int > > atomics;
+		for( unsigned int i = 0; i < AMOUNT_OF_OBJECTS; ++i )
+			atomics.push_back( LibThreadIt::Atomic< int >( &counts[ i ] ) );
+		std::atomic< int > overlaps( 0 );
+		std::vector< std::thread > threads;
+		for( unsigned int i = 0; i < AMOUNT_OF_THREADS; ++i )
+		{
+			threads.push_back( std::thread( [ &, i ]() {
+					std::vector< LibThreadIt::Atomic< int > > copies( atomics );
+					std::uint32_t random = i * 2654435761u + 1;
+					for( unsigned int j = 0; j < ROUNDS; ++j )
+					{
+						random = random * 1664525u + 1013904223u;
+						//Most rounds go to a few objects, so threads meet on them.//
+						const unsigned int OBJECT = ( ( random >> 8 ) % 4 == 0 ) ? 
+								( random >> 12 ) % AMOUNT_OF_OBJECTS : ( random >> 12 ) % 8;
+						int* count = *copies[ OBJECT ];
+						if( inside[ OBJECT ].exchange( 1 ) != 0 )
+							overlaps.fetch_add( 1 );
+						++( *count );
+						inside[ OBJECT ].store( 0 );
+						copies[ OBJECT ].Release();
+					}
+				} ) );
+		}
+		for( unsigned int i = 0; i < AMOUNT_OF_THREADS; ++i )
+			threads[ i ].join();
+		int total = 0;
+		for( unsigned int i = 0; i < AMOUNT_OF_OBJECTS; ++i )
+			total += counts[ i ];
+		Check( overlaps.load() == 0, "An object's lock word has one holder at a time" );
+		Check( total == int( AMOUNT_OF_THREADS * ROUNDS ), "No increments are lost when lock words are reused" );
+	}
+}
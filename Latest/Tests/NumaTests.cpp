@@ -0,0 +1,88 @@
+/*
+Copyright (C) 2013 Christopher A. Greeley
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), 
+to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, 
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+#include <TestSupport.h>
+#include <algorithm>
+#include <sched.h>
+
+//NUMA topologies, simulated ones included, and memory kept on a node.//
+namespace ThreadItTests
+{
+	//A zero byte block still comes from the node's smallest size class, and goes back to it.//
+	void TestZeroSizedNodeAllocation()
+	{
+		void* memory = LibThreadIt::Implementation::AllocateOnNode( 0, 0 );
+		Check( memory != nullptr, "AllocateOnNode gives a block for zero bytes" );
+		LibThreadIt::Implementation::FreeOnNode( memory, 0, 0 );
+		void* again = LibThreadIt::Implementation::AllocateOnNode( 1, 0 );
+		Check( again == memory, "A zero byte block is reused for the smallest size class" );
+		LibThreadIt::Implementation::FreeOnNode( again, 1, 0 );
+	}
+	/*A pool on two simulated nodes, the same split THREAD_IT_NUMA_NODES=2 makes, has 
+	a worker per CPU of each node and every worker runs on its own node's CPUs.*/
+	void TestNumaWorkerPlacement()
+	{
+		LibThreadIt::NumaTopology split = LibThreadIt::NumaTopology::Simulated( 2, 4 );
+		Check( split.IsSimulated() == true && split.GetAmountOfNodes() == 2 && split.GetCpus( 0 ) == std::vector< int >( { 0, 2 } ) && 
+				split.GetCpus( 1 ) == std::vector< int >( { 1, 3 } ) && split.NodeOfCpu( 3 ) == 1, 
+				"Simulated nodes share the CPUs round robin" );
+		LibThreadIt::NumaTopology sparse = LibThreadIt::NumaTopology::Simulated( 3, 2 );
+		Check( sparse.GetCpus( 2 ) == std::vector< int >( { 0 } ) && sparse.NodeOfCpu( 0 ) == 0, 
+				"A simulated node without a CPU of its own gets CPU 0" );
+		//Workers can only be pinned to CPUs we may run on, so the nodes split those.//
+		cpu_set_t allowed;
+		CPU_ZERO( &allowed );
+		sched_getaffinity( 0, sizeof( allowed ), &allowed );
+		const unsigned int AMOUNT_OF_CPUS = std::max( CPU_COUNT( &allowed ), 1 );
+		bool isPinnable = true;
+		for( unsigned int cpu = 0; cpu < AMOUNT_OF_CPUS; ++cpu )
+			if( CPU_ISSET( cpu, &allowed ) == 0 )
+				isPinnable = false;
+		LibThreadIt::NumaTopology topology = LibThreadIt::NumaTopology::Simulated( 2, AMOUNT_OF_CPUS );
+		LibThreadIt::Implementation::WorkerPool pool( topology );
+		const unsigned int AMOUNT_OF_WORKERS = pool.GetAmountOfWorkers();
+		Check( pool.GetAmountOfNodes() == 2 && AMOUNT_OF_WORKERS == topology.GetCpus( 0 ).size() + topology.GetCpus( 1 ).size(), 
+				"A pool has a worker per CPU of each node" );
+		std::vector< unsigned int > expectedPerNode( 2, 0 );
+		for( unsigned int i = 0; i < AMOUNT_OF_WORKERS; ++i )
+			++expectedPerNode[ pool.GetNodeOfWorker( i ) ];
+		//Each task holds its worker until every worker has one, so each runs on a different worker.//
+		std::atomic< unsigned int > amountArrived( 0 );
+		std::atomic< unsigned int > amountDone( 0 );
+		std::atomic< unsigned int > amountOffNode( 0 );
+		std::vector< std::atomic< unsigned int > > perNode( 2 );
+		for( unsigned int i = 0; i < AMOUNT_OF_WORKERS; ++i )
+		{
+			pool.SubmitFunction( [ & ]() {
+					const unsigned int NODE = pool.CurrentNode();
+					cpu_set_t running;
+					CPU_ZERO( &running );
+					sched_getaffinity( 0, sizeof( running ), &running );
+					const std::vector< int >& CPUS = topology.GetCpus( NODE );
+					for( int cpu = 0; cpu < CPU_SETSIZE; ++cpu )
+						if( CPU_ISSET( cpu, &running ) != 0 && std::find( CPUS.begin(), CPUS.end(), cpu ) == CPUS.end() )
+							amountOffNode.fetch_add( 1 );
+					perNode[ NODE ].fetch_add( 1 );
+					amountArrived.fetch_add( 1 );
+					for( int j = 0; j < 10000 && amountArrived.load() != AMOUNT_OF_WORKERS; ++j )
+						Sleep( 1 );
+					amountDone.fetch_add( 1, std::memory_order_release );
+				} );
+		}
+		for( int i = 0; i < 20000 && amountDone.load( std::memory_order_acquire ) != AMOUNT_OF_WORKERS; ++i )
+			Sleep( 1 );
+		Check( perNode[ 0 ].load() == expectedPerNode[ 0 ] && perNode[ 1 ].load() == expectedPerNode[ 1 ], 
+				"Each node's workers run on that node" );
+		Check( isPinnable == false || amountOffNode.load() == 0, "Workers are pinned to their node's CPUs" );
+	}
+}
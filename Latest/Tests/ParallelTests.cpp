@@ -0,0 +1,53 @@
+/*
+Copyright (C) 2013 Christopher A. Greeley
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), 
+to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, 
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+#include <TestSupport.h>
+#include <string>
+
+//ParallelFor and ParallelReduce over ranges split across the pool.//
+namespace ThreadItTests
+{
+	/*Concatenation is associative but not commutative, so the reduced string only 
+	matches the serial one if partials are combined in index order.*/
+	void TestParallelReduceKeepsOrder()
+	{
+		const std::size_t AMOUNT = 5000;
+		std::string expected;
+		for( std::size_t i = 0; i < AMOUNT; ++i )
+			expected += static_cast< char >( 'a' + i % 26 );
+		const std::size_t GRAINS[] = { 0, 1, 7, AMOUNT };
+		bool isInOrder = true;
+		for( std::size_t grain : GRAINS )
+		{
+			std::string reduced = LibThreadIt::ParallelReduce( LibThreadIt::IndexRange( 0, AMOUNT ), std::string(), 
+					[]( std::string& partial, std::size_t index ) { partial += static_cast< char >( 'a' + index % 26 ); }, 
+					[]( std::string left, std::string right ) { return left + right; }, grain );
+			if( reduced != expected )
+				isInOrder = false;
+		}
+		Check( isInOrder == true, "ParallelReduce combines partials in index order" );
+		Check( LibThreadIt::ParallelReduce( LibThreadIt::IndexRange( 3, 3 ), std::string( "identity" ), 
+				[]( std::string& partial, std::size_t ) { partial += 'x'; }, 
+				[]( std::string left, std::string right ) { return left + right; } ) == "identity", 
+				"ParallelReduce over an empty range gives the identity" );
+		std::vector< std::atomic< int > > visits( AMOUNT );
+		LibThreadIt::ParallelFor( LibThreadIt::IndexRange( 0, AMOUNT ), 3, [ &visits ]( std::size_t index ) {
+				visits[ index ].fetch_add( 1, std::memory_order_relaxed );
+			} );
+		bool isOnce = true;
+		for( std::size_t i = 0; i < AMOUNT; ++i )
+			if( visits[ i ].load() != 1 )
+				isOnce = false;
+		Check( isOnce == true, "ParallelFor runs every index once" );
+	}
+}
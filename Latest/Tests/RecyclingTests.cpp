@@ -0,0 +1,37 @@
+/*
+Copyright (C) 2013 Christopher A. Greeley
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), 
+to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, 
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+#include <TestSupport.h>
+
+//Managers and their shards, kept for the next manager when one is destroyed.//
+namespace ThreadItTests
+{
+	//A manager made after another was destroyed takes over its shards, Branch then does not allocate.//
+	void TestRecycledManagersKeepTheirShards()
+	{
+		std::vector< int > data( 16 );
+		unsigned int allocations = 0;
+		for( unsigned int round = 1; round <= 4; ++round )
+		{
+			allocations = amountOfAllocations.load();
+			isCountingAllocations = ( round == 4 );
+			{
+				ATOMIC_RESOURCE pool = LibThreadIt::MakeAtomicResource();
+				for( unsigned int i = 0; i < data.size(); ++i )
+					pool->Branch( &data[ i ] );
+			}
+			isCountingAllocations = false;
+		}
+		Check( amountOfAllocations.load() == allocations, "A recycled manager branches without allocating" );
+	}
+}
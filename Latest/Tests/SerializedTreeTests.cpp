@@ -0,0 +1,74 @@
+/*
+Copyright (C) 2013 Christopher A. Greeley
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), 
+to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, 
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+#include <TestSupport.h>
+
+//Pooled threads in a SERIALIZE_TREE tree.//
+namespace ThreadItTests
+{
+	namespace
+	{
+		std::atomic< int > amountInTree( 0 );
+		std::atomic< int > mostInTree( 0 );
+		std::atomic< int > amountRunInTree( 0 );
+		void RunInTree( int )
+		{
+			const int INSIDE = amountInTree.fetch_add( 1 ) + 1;
+			int most = mostInTree.load();
+			while( INSIDE > most && mostInTree.compare_exchange_weak( most, INSIDE ) == false );
+			Sleep( 1 );
+			amountRunInTree.fetch_add( 1 );
+			amountInTree.fetch_sub( 1 );
+		}
+	}
+	/*Workers launching more serialized pooled children than there are workers, 
+	none of them may wait for the tree.*/
+	void TestSerializedPooledTree()
+	{
+		LibThreadIt::ThreadAttributes attributes;
+		attributes.launchMode = LibThreadIt::POOLED_THREAD;
+		THREAD_HANDLE root = LibThreadIt::ThreadItInitialize( attributes, LibThreadIt::DO_NOT_AQUIRE_ALL_ON_START, 
+				LibThreadIt::JOIN, &RunInTree, 0 );
+		root->Join();
+		const unsigned int AMOUNT_OF_LAUNCHERS = std::thread::hardware_concurrency() * 2 + 2;
+		std::vector< LibThreadIt::Task< void > > launchers;
+		for( unsigned int i = 0; i < AMOUNT_OF_LAUNCHERS; ++i )
+		{
+			launchers.push_back( LibThreadIt::ThreadItTask( [ root, attributes ]() {
+					std::vector< THREAD_HANDLE > children;
+					for( int j = 0; j < 4; ++j )
+						children.push_back( LibThreadIt::ThreadIt( attributes, LibThreadIt::DO_NOT_AQUIRE_ALL_ON_START, 
+								root, LibThreadIt::JOIN, &RunInTree, j ) );
+					for( int j = 0; j < 4; ++j )
+						children[ j ]->Join();
+				} ) );
+		}
+		for( unsigned int i = 0; i < AMOUNT_OF_LAUNCHERS; ++i )
+			launchers[ i ].Join();
+		Check( amountRunInTree.load() == int( 1 + AMOUNT_OF_LAUNCHERS * 4 ), "Every serialized pooled child ran" );
+		Check( mostInTree.load() == 1, "Serialized pooled children ran one at a time" );
+		//Batches in a serialized tree queue for it the same way.//
+		launchers.clear();
+		amountRunInTree.store( 0 );
+		for( unsigned int i = 0; i < AMOUNT_OF_LAUNCHERS; ++i )
+		{
+			launchers.push_back( LibThreadIt::ThreadItTask( [ root ]() {
+					std::vector< int > arguments( 3 );
+					LibThreadIt::ThreadItBatch( root, &RunInTree, arguments ).JoinAll();
+				} ) );
+		}
+		for( unsigned int i = 0; i < AMOUNT_OF_LAUNCHERS; ++i )
+			launchers[ i ].Join();
+		Check( amountRunInTree.load() == int( AMOUNT_OF_LAUNCHERS * 3 ), "Every task of every serialized batch ran" );
+	}
+}
@@ -0,0 +1,65 @@
+/*
+Copyright (C) 2013 Christopher A. Greeley
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), 
+to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, 
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+#include <TestSupport.h>
+
+//Tasks on the worker pool, joined from inside and outside it.//
+namespace ThreadItTests
+{
+	namespace
+	{
+		int SlowDouble( int value ) {
+			Sleep( 20 );
+			return value * 2;
+		}
+	}
+	//Joining from outside the pool parks, joining from a task helps run the pool.//
+	void TestTaskJoin()
+	{
+		LibThreadIt::Task< int > task = LibThreadIt::ThreadItTask( &SlowDouble, 21 );
+		Check( task.GetResult() == 42, "Task::GetResult wakes after the task finishes" );
+		Check( task.IsDone() == true, "Task::IsDone after a join" );
+		LibThreadIt::Task< int > nested = LibThreadIt::ThreadItTask( []() {
+				std::vector< LibThreadIt::Task< int > > children;
+				for( int i = 0; i < 64; ++i )
+					children.push_back( LibThreadIt::ThreadItTask( []( int value ) { return value; }, i ) );
+				int total = 0;
+				for( int i = 0; i < 64; ++i )
+					total += children[ i ].GetResult();
+				return total;
+			} );
+		Check( nested.GetResult() == 2016, "Tasks joined from a worker all finish" );
+		LibThreadIt::Task< void > empty;
+		Check( empty.IsValid() == false && empty.IsDone() == true, "A default constructed Task counts as done" );
+		empty.Join();
+	}
+	/*Detached tasks launched from outside the pool are freed by the workers, their 
+	nodes still have to come back so the launching thread stops allocating.*/
+	void TestDetachedTasksReuseNodes()
+	{
+		const unsigned int AMOUNT_OF_TASKS = 64;
+		std::atomic< unsigned int > finished( 0 );
+		for( unsigned int round = 1; round <= 8; ++round )
+		{
+			isCountingAllocations = ( round == 8 );
+			for( unsigned int i = 0; i < AMOUNT_OF_TASKS; ++i )
+				LibThreadIt::ThreadItTask( [ &finished ]() { finished.fetch_add( 1, std::memory_order_release ); } );
+			isCountingAllocations = false;
+			while( finished.load( std::memory_order_acquire ) != round * AMOUNT_OF_TASKS )
+				std::this_thread::yield();
+			//The workers drop their references just after the tasks count themselves finished.//
+			Sleep( 10 );
+		}
+		Check( amountOfAllocations.load() == 0, "Detached tasks launched from outside the pool do not allocate once warm" );
+	}
+}
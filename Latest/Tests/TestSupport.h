@@ -0,0 +1,83 @@
+/*
+Copyright (C) 2013 Christopher A. Greeley
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), 
+to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, 
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+#pragma once
+#include <ThreadIt.h>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <string>
+
+/*Behaviour tests for ThreadIt, build with build_linux.txt. Each failed check is 
+printed to standard error, the exit code is the number of failed checks. Each file 
+tests one part of the library, ThreadItTests.cpp has the helpers and runs them all.*/
+namespace ThreadItTests
+{
+	void Check( bool passed, const char* what );
+	void Sleep( unsigned int milliseconds );
+	void WaitForGate( std::atomic< bool >* gate );
+	//Set on a thread to count its calls to the global allocator in "amountOfAllocations."//
+	extern thread_local bool isCountingAllocations;
+	extern std::atomic< unsigned int > amountOfAllocations;
+	//ThreadAttributeTests.cpp//
+	void TestCpuAffinity();
+	void TestStackSize();
+	void TestThreadName();
+	//SerializedTreeTests.cpp//
+	void TestSerializedPooledTree();
+	//LockTableTests.cpp//
+	void TestCopiedAtomicOutlivesPool();
+	void TestLockWordsAreReused();
+	//FutureTests.cpp//
+	void TestFutureWake();
+	void TestFutureSetOnce();
+	//TaskTests.cpp//
+	void TestTaskJoin();
+	void TestDetachedTasksReuseNodes();
+	//BatchTests.cpp//
+	void TestBatchJoin();
+	//RecyclingTests.cpp//
+	void TestRecycledManagersKeepTheirShards();
+	//CoroutineTests.cpp//
+	#if defined( __cpp_impl_coroutine )
+		void TestCoroutines();
+		void TestCoroutineReadersShare();
+	#endif
+	//WaitTests.cpp//
+	void TestWaitTimeouts();
+	//AtomicManagerTests.cpp//
+	void TestAquireAllOnStartExcludes();
+	void TestAquireAllPairsPerThread();
+	void TestReleaseAllOnAnotherThread();
+	void TestAquireAllReusesHolds();
+	//ChannelTests.cpp//
+	void TestChannelExactlyOnce();
+	void TestChannelBlocks();
+	void TestChannelCloseDrains();
+	//TimerTests.cpp//
+	void TestTimerNeverEarly();
+	void TestTimerCancelBeforeDue();
+	void TestPeriodicTimerStops();
+	void TestTimerOverflowCascades();
+	//VersionedAtomicTests.cpp//
+	void TestVersionedAtomicNeverTears();
+	//AtomicPoolTests.cpp//
+	void TestAtomicPoolsInOppositeOrder();
+	//ParallelTests.cpp//
+	void TestParallelReduceKeepsOrder();
+	//ContentionProfilerTests.cpp//
+	void TestContentionProfilerHottest();
+	//NumaTests.cpp//
+	void TestZeroSizedNodeAllocation();
+	void TestNumaWorkerPlacement();
+}
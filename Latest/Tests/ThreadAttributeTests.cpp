@@ -0,0 +1,87 @@
+/*
+Copyright (C) 2013 Christopher A. Greeley
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), 
+to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, 
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+#include <TestSupport.h>
+#include <pthread.h>
+#include <sched.h>
+
+//ThreadAttributes on an OS_THREAD launch, checked from inside the thread.//
+namespace ThreadItTests
+{
+	namespace
+	{
+		struct ThreadProbe
+		{
+			cpu_set_t cpus;
+			std::size_t stackSize;
+			char name[ 16 ];
+		};
+		void Probe( ThreadProbe* probe )
+		{
+			CPU_ZERO( &probe->cpus );
+			sched_getaffinity( 0, sizeof( probe->cpus ), &probe->cpus );
+			probe->stackSize = 0;
+			pthread_attr_t attributes;
+			if( pthread_getattr_np( pthread_self(), &attributes ) == 0 ) {
+				pthread_attr_getstacksize( &attributes, &probe->stackSize );
+				pthread_attr_destroy( &attributes );
+			}
+			probe->name[ 0 ] = '\0';
+			pthread_getname_np( pthread_self(), probe->name, sizeof( probe->name ) );
+		}
+		ThreadProbe ProbeThread( const LibThreadIt::ThreadAttributes& attributes )
+		{
+			ThreadProbe probe;
+			THREAD_HANDLE handle = LibThreadIt::ThreadItInitialize( attributes, LibThreadIt::DO_NOT_AQUIRE_ALL_ON_START, 
+					LibThreadIt::JOIN, &Probe, &probe );
+			handle->Join();
+			return probe;
+		}
+	}
+	//Pinned to the last CPU this process may use, the thread may run nowhere else.//
+	void TestCpuAffinity()
+	{
+		cpu_set_t allowed;
+		CPU_ZERO( &allowed );
+		sched_getaffinity( 0, sizeof( allowed ), &allowed );
+		int last = -1;
+		for( int i = 0; i < CPU_SETSIZE; ++i )
+			if( CPU_ISSET( i, &allowed ) )
+				last = i;
+		LibThreadIt::ThreadAttributes attributes;
+		attributes.cpuAffinity.push_back( last );
+		ThreadProbe probe = ProbeThread( attributes );
+		Check( CPU_COUNT( &probe.cpus ) == 1 && CPU_ISSET( last, &probe.cpus ), "cpuAffinity pins the thread" );
+		ThreadProbe unpinned = ProbeThread( LibThreadIt::ThreadAttributes() );
+		Check( CPU_EQUAL( &unpinned.cpus, &allowed ), "No cpuAffinity leaves the thread where the process may run" );
+	}
+	//Well below the usual 8 MiB default, so the default can not pass for it.//
+	void TestStackSize()
+	{
+		const std::size_t STACK_SIZE = 1024 * 1024;
+		LibThreadIt::ThreadAttributes attributes;
+		attributes.stackSize = STACK_SIZE;
+		ThreadProbe probe = ProbeThread( attributes );
+		Check( probe.stackSize >= STACK_SIZE && probe.stackSize < STACK_SIZE + 64 * 1024, 
+				"stackSize sets the thread's stack size" );
+	}
+	void TestThreadName()
+	{
+		LibThreadIt::ThreadAttributes attributes;
+		attributes.name = "ThreadItTests";
+		Check( std::string( ProbeThread( attributes ).name ) == "ThreadItTests", "name names the thread" );
+		attributes.name = "ThreadItTestsWithALongName";
+		Check( std::string( ProbeThread( attributes ).name ) == "ThreadItTestsWi", 
+				"A name past 15 characters is cut short instead of failing" );
+	}
+}
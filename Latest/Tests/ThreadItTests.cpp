@@ -0,0 +1,97 @@
+/*
+Copyright (C) 2013 Christopher A. Greeley
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), 
+to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, 
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+#include <TestSupport.h>
+#include <cstdlib>
+#include <new>
+
+namespace ThreadItTests
+{
+	thread_local bool isCountingAllocations = false;
+	std::atomic< unsigned int > amountOfAllocations( 0 );
+	namespace
+	{
+		unsigned int amountOfFailures = 0;
+	}
+	void Check( bool passed, const char* what )
+	{
+		if( passed == false ) {
+			std::fprintf( stderr, "FAILED: %s\n", what );
+			++amountOfFailures;
+		}
+	}
+	void Sleep( unsigned int milliseconds ) {
+		std::this_thread::sleep_for( std::chrono::milliseconds( milliseconds ) );
+	}
+	void WaitForGate( std::atomic< bool >* gate )
+	{
+		while( gate->load( std::memory_order_acquire ) == false )
+			Sleep( 1 );
+	}
+}
+void* operator new( std::size_t size )
+{
+	if( ThreadItTests::isCountingAllocations == true )
+		ThreadItTests::amountOfAllocations.fetch_add( 1, std::memory_order_relaxed );
+	void* memory = std::malloc( ( size == 0 ) ? 1 : size );
+	if( memory == nullptr )
+		throw std::bad_alloc();
+	return memory;
+}
+void operator delete( void* memory ) noexcept {
+	std::free( memory );
+}
+void operator delete( void* memory, std::size_t ) noexcept {
+	std::free( memory );
+}
+int main()
+{
+	using namespace ThreadItTests;
+	TestCpuAffinity();
+	TestStackSize();
+	TestThreadName();
+	TestFutureWake();
+	TestFutureSetOnce();
+	TestTaskJoin();
+	TestBatchJoin();
+	TestDetachedTasksReuseNodes();
+	TestWaitTimeouts();
+	TestAquireAllOnStartExcludes();
+	TestAquireAllPairsPerThread();
+	TestAquireAllReusesHolds();
+	TestRecycledManagersKeepTheirShards();
+	TestReleaseAllOnAnotherThread();
+	TestCopiedAtomicOutlivesPool();
+	TestLockWordsAreReused();
+	TestSerializedPooledTree();
+	#if defined( __cpp_impl_coroutine )
+		TestCoroutines();
+		TestCoroutineReadersShare();
+	#endif
+	TestChannelExactlyOnce();
+	TestChannelBlocks();
+	TestChannelCloseDrains();
+	TestTimerNeverEarly();
+	TestTimerCancelBeforeDue();
+	TestPeriodicTimerStops();
+	TestTimerOverflowCascades();
+	TestVersionedAtomicNeverTears();
+	TestAtomicPoolsInOppositeOrder();
+	TestParallelReduceKeepsOrder();
+	TestContentionProfilerHottest();
+	TestZeroSizedNodeAllocation();
+	TestNumaWorkerPlacement();
+	if( amountOfFailures == 0 )
+		std::fprintf( stderr, "All tests passed\n" );
+	return amountOfFailures;
+}
@@ -0,0 +1,130 @@
+/*
+Copyright (C) 2013 Christopher A. Greeley
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), 
+to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, 
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+#include <TestSupport.h>
+#include <memory>
+
+//Timers on the wheel, one shot, periodic, cancelled and far off.//
+namespace ThreadItTests
+{
+	namespace
+	{
+		/*A wheel the test moves forward by hand, so a timer hours away is reached 
+		without waiting for it. Its own service thread only ever moves it to the real 
+		time, which stays behind.*/
+		class SteppedWheel : public LibThreadIt::Implementation::TimerWheel
+		{
+			public: 
+				//Moves the wheel to "tick" and runs what is due, returns how many that was.//
+				std::size_t StepTo( std::uint64_t tick )
+				{
+					std::vector< LibThreadIt::Implementation::PoolTask* > due;
+					{
+						std::lock_guard< std::mutex > lock( guard );
+						Advance( tick, due );
+					}
+					Dispatch( due );
+					return due.size();
+				}
+				int LevelOf( LibThreadIt::Implementation::TimerNode* node ) {
+					std::lock_guard< std::mutex > lock( guard );
+					return node->level;
+				}
+		};
+		void Increment( std::atomic< int >* count ) {
+			count->fetch_add( 1, std::memory_order_release );
+		}
+		void WaitForCount( std::atomic< int >* count, int amount )
+		{
+			for( int i = 0; i < 5000 && count->load( std::memory_order_acquire ) < amount; ++i )
+				Sleep( 1 );
+		}
+	}
+	//However the delay falls between ticks, the callback never runs before it has passed.//
+	void TestTimerNeverEarly()
+	{
+		const int AMOUNT_OF_TIMERS = 20;
+		std::vector< std::chrono::steady_clock::time_point > firedAt( AMOUNT_OF_TIMERS );
+		std::atomic< int > amountFired( 0 );
+		std::vector< std::chrono::steady_clock::time_point > startedAt( AMOUNT_OF_TIMERS );
+		for( int i = 0; i < AMOUNT_OF_TIMERS; ++i )
+		{
+			startedAt[ i ] = std::chrono::steady_clock::now();
+			LibThreadIt::ThreadItAfter( std::chrono::microseconds( 500 + i * 1300 ), [ &firedAt, &amountFired, i ]() {
+					firedAt[ i ] = std::chrono::steady_clock::now();
+					amountFired.fetch_add( 1, std::memory_order_release );
+				} );
+		}
+		WaitForCount( &amountFired, AMOUNT_OF_TIMERS );
+		bool isEarly = false;
+		for( int i = 0; i < AMOUNT_OF_TIMERS; ++i )
+			if( firedAt[ i ] - startedAt[ i ] < std::chrono::microseconds( 500 + i * 1300 ) )
+				isEarly = true;
+		Check( amountFired.load() == AMOUNT_OF_TIMERS, "Every one shot timer fires" );
+		Check( isEarly == false, "A one shot timer never fires before its delay" );
+	}
+	//A timer cancelled before it is due says so, and its callback never runs.//
+	void TestTimerCancelBeforeDue()
+	{
+		std::atomic< int > count( 0 );
+		LibThreadIt::TimerHandle timer = LibThreadIt::ThreadItAfter( std::chrono::milliseconds( 30 ), &Increment, &count );
+		Check( timer.IsPending() == true, "A timer is pending until it is due" );
+		Check( timer.Cancel() == true, "Cancel before the timer is due returns 'true'" );
+		Check( timer.IsPending() == false && timer.Cancel() == false, "A cancelled timer is no longer pending" );
+		Sleep( 80 );
+		Check( count.load() == 0, "A timer cancelled before it is due never runs" );
+		LibThreadIt::TimerHandle fired = LibThreadIt::ThreadItAfter( std::chrono::milliseconds( 1 ), &Increment, &count );
+		WaitForCount( &count, 1 );
+		Sleep( 5 );
+		Check( fired.Cancel() == false, "Cancel after the timer ran returns 'false'" );
+		Check( LibThreadIt::TimerHandle().Cancel() == false, "Cancel on an empty TimerHandle" );
+	}
+	//After Cancel returns a periodic timer fires no more, bar a callback already running.//
+	void TestPeriodicTimerStops()
+	{
+		std::atomic< int > count( 0 );
+		LibThreadIt::TimerHandle timer = LibThreadIt::ThreadItEvery( std::chrono::milliseconds( 2 ), &Increment, &count );
+		WaitForCount( &count, 5 );
+		Check( count.load() >= 5, "A periodic timer keeps firing" );
+		timer.Cancel();
+		const int AT_CANCEL = count.load( std::memory_order_acquire );
+		Sleep( 10 );
+		const int SETTLED = count.load( std::memory_order_acquire );
+		Sleep( 40 );
+		Check( SETTLED - AT_CANCEL <= 1 && count.load() == SETTLED, "A cancelled periodic timer stops firing" );
+		Check( timer.IsPending() == false, "A cancelled periodic timer is not pending" );
+	}
+	/*A timer past the last level waits on the overflow list, comes down the levels 
+	as the wheel reaches it, and fires on its tick, not before.*/
+	void TestTimerOverflowCascades()
+	{
+		const std::uint64_t FAR_OFF = ( std::uint64_t( 1 ) << 24 ) + 1000;
+		std::atomic< int > count( 0 );
+		SteppedWheel wheel;
+		std::shared_ptr< LibThreadIt::Implementation::TimerNode > node = 
+				std::make_shared< LibThreadIt::Implementation::TimerNode >();
+		node->callback = std::bind( &Increment, &count );
+		wheel.Schedule( node, std::chrono::milliseconds( FAR_OFF ) );
+		Check( wheel.LevelOf( node.get() ) == LibThreadIt::Implementation::TimerWheel::OVERFLOW_LEVEL, 
+				"A timer more than 2^24 ticks away goes on the overflow list" );
+		const std::uint64_t EXPIRY = node->expiry;
+		Check( wheel.StepTo( std::uint64_t( 1 ) << 24 ) == 0, "Reaching the overflow list does not fire what is on it" );
+		const int LEVEL = wheel.LevelOf( node.get() );
+		Check( LEVEL >= 0 && LEVEL < LibThreadIt::Implementation::TimerWheel::OVERFLOW_LEVEL, 
+				"The overflow list cascades onto the wheel" );
+		Check( wheel.StepTo( EXPIRY - 1 ) == 0 && count.load() == 0, "A cascaded timer does not fire early" );
+		Check( wheel.StepTo( EXPIRY ) == 1, "A cascaded timer fires on its tick" );
+		WaitForCount( &count, 1 );
+		Check( count.load() == 1, "A cascaded timer's callback runs" );
+	}
+}
@@ -0,0 +1,88 @@
+/*
+Copyright (C) 2013 Christopher A. Greeley
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), 
+to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, 
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+#include <TestSupport.h>
+
+//VersionedAtomic read while several threads write it.//
+namespace ThreadItTests
+{
+	namespace
+	{
+		//Spans several words, a torn read shows as fields that differ.//
+		struct Wide
+		{
+			std::uint64_t fields[ 8 ];
+			bool IsWhole() const
+			{
+				for( unsigned int i = 1; i < 8; ++i )
+					if( fields[ i ] != fields[ 0 ] )
+						return ( false );
+				return ( true );
+			}
+		};
+	}
+	/*Writers store and update a value whose fields always match, readers must never 
+	see a mix of two writes, and no update may be lost.*/
+	void TestVersionedAtomicNeverTears()
+	{
+		const unsigned int AMOUNT_OF_WRITERS = 3;
+		const unsigned int AMOUNT_OF_READERS = 3;
+		const unsigned int WRITES_EACH = 20000;
+		LibThreadIt::VersionedAtomic< Wide > value;
+		std::atomic< bool > isWriting( true );
+		std::atomic< unsigned int > amountTorn( 0 );
+		std::vector< std::thread > readers;
+		for( unsigned int i = 0; i < AMOUNT_OF_READERS; ++i )
+		{
+			readers.push_back( std::thread( [ &value, &isWriting, &amountTorn ]() {
+					do
+					{
+						if( value.Load().IsWhole() == false )
+							amountTorn.fetch_add( 1 );
+						Wide tried;
+						if( value.TryLoad( tried ) == true && tried.IsWhole() == false )
+							amountTorn.fetch_add( 1 );
+					}
+					while( isWriting.load( std::memory_order_acquire ) == true );
+				} ) );
+		}
+		std::vector< std::thread > writers;
+		for( unsigned int i = 0; i < AMOUNT_OF_WRITERS; ++i )
+		{
+			writers.push_back( std::thread( [ &value ]() {
+					for( unsigned int j = 0; j < WRITES_EACH; ++j )
+					{
+						value.Update( []( Wide& wide ) {
+								for( unsigned int k = 0; k < 8; ++k )
+									++wide.fields[ k ];
+							} );
+					}
+				} ) );
+		}
+		for( unsigned int i = 0; i < AMOUNT_OF_WRITERS; ++i )
+			writers[ i ].join();
+		isWriting.store( false, std::memory_order_release );
+		for( unsigned int i = 0; i < AMOUNT_OF_READERS; ++i )
+			readers[ i ].join();
+		Wide last = value.Load();
+		Check( amountTorn.load() == 0, "A VersionedAtomic read never sees two writes mixed" );
+		Check( last.IsWhole() == true && last.fields[ 0 ] == AMOUNT_OF_WRITERS * WRITES_EACH, 
+				"VersionedAtomic::Update loses no updates" );
+		Check( value.GetVersion() == 2 * AMOUNT_OF_WRITERS * WRITES_EACH, "Every write moves the version by two" );
+		Wide stored;
+		for( unsigned int k = 0; k < 8; ++k )
+			stored.fields[ k ] = 7;
+		value.Store( stored );
+		Check( value.Load().fields[ 7 ] == 7, "VersionedAtomic::Store" );
+	}
+}
@@ -0,0 +1,47 @@
+/*
+Copyright (C) 2013 Christopher A. Greeley
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), 
+to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, 
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+#include <TestSupport.h>
+
+//Waiting on several handles at once, with and without a timeout.//
+namespace ThreadItTests
+{
+	//Waits that time out have to come back, and leave the handles usable.//
+	void TestWaitTimeouts()
+	{
+		std::atomic< bool > gate( false );
+		std::vector< THREAD_HANDLE > handles;
+		for( unsigned int i = 0; i < 2; ++i )
+		{
+			LibThreadIt::ThreadAttributes attributes;
+			attributes.launchMode = ( i == 0 ) ? LibThreadIt::OS_THREAD : LibThreadIt::POOLED_THREAD;
+			handles.push_back( LibThreadIt::ThreadItInitialize( attributes, LibThreadIt::DO_NOT_AQUIRE_ALL_ON_START, 
+					LibThreadIt::JOIN, &WaitForGate, &gate ) );
+		}
+		auto start = std::chrono::steady_clock::now();
+		Check( LibThreadIt::WaitAllFor( handles, std::chrono::milliseconds( 30 ) ) == false, 
+				"WaitAllFor times out while the handles run" );
+		Check( LibThreadIt::WaitAnyFor( handles, std::chrono::milliseconds( 30 ) ) == handles.size(), 
+				"WaitAnyFor times out while the handles run" );
+		Check( std::chrono::steady_clock::now() - start < std::chrono::seconds( 5 ), "Timed out waits come back on time" );
+		gate.store( true, std::memory_order_release );
+		Check( LibThreadIt::WaitAnyFor( handles, std::chrono::seconds( 10 ) ) < handles.size(), 
+				"WaitAnyFor sees a handle finish" );
+		Check( LibThreadIt::WaitAllFor( handles, std::chrono::seconds( 10 ) ) == true, 
+				"WaitAllFor sees every handle finish" );
+		LibThreadIt::WaitAll( handles );
+		Check( LibThreadIt::WaitAny( std::vector< THREAD_HANDLE >() ) == 0, "WaitAny on no handles" );
+		for( unsigned int i = 0; i < handles.size(); ++i )
+			handles[ i ]->Join();
+	}
+}
@@ -23,12 +23,251 @@ namespace LibThreadIt
 				auto castedThreadHandle = ( ( GoogleNativeClientThreadHandle* ) threadHandle );
 				castedThreadHandle->RunOnThread();
 				//This is safe because none of the data on the thread is being manipulated any more.//
-				castedThreadHandle->GetStateGuard()->UnLock();
+				if( castedThreadHandle->SerializesTree() == true )
+					castedThreadHandle->GetStateGuard()->UnLock();
 				if( castedThreadHandle->GetManagementBehavior() == AQUIRE_ALL_ON_START )
 					castedThreadHandle->ReleaseAll();
 				castedThreadHandle->SetDataIsSafe( true );
+				castedThreadHandle->SignalCompletion();
 				return ( NULL );
 			}
 		#endif
+		#ifdef THREAD_IT_POSIX_PLATFORM
+			void* PosixRunOnThread( void* threadHandle )
+			{
+				auto castedThreadHandle = ( ( PosixThreadHandle* ) threadHandle );
+				//Empty unless the handle is detached, then it lives until we return.//
+				auto keepAlive = castedThreadHandle->TakeKeepAlive();
+				castedThreadHandle->RunOnThread();
+				if( castedThreadHandle->SerializesTree() == true )
+					castedThreadHandle->GetStateGuard()->UnLock();
+				if( castedThreadHandle->GetManagementBehavior() == AQUIRE_ALL_ON_START )
+					castedThreadHandle->ReleaseAll();
+				castedThreadHandle->SetDataIsSafe( true );
+				castedThreadHandle->SignalCompletion();
+				return ( NULL );
+			}
+			void PooledThreadHandle::RunOnWorker()
+			{
+				//Empty unless the handle is detached, then it lives until we return.//
+				std::shared_ptr< PooledThreadHandle > detachedSelf;
+				detachedSelf.swap( keepAlive );
+				//Already held unless the launch was queued behind the tree.//
+				if( managmentBehavior == AQUIRE_ALL_ON_START )
+					AquireAll();
+				ExecuteProcedure();
+				if( SerializesTree() == true )
+					stateGuard->UnLock();
+				if( managmentBehavior == AQUIRE_ALL_ON_START )
+					ReleaseAll();
+				SetDataIsSafe( true );
+				SignalCompletion();
+				/*A joining thread may destroy the handle as soon as it sees "isComplete, " 
+				nothing may touch "this" after the lock is released.*/
+				std::lock_guard< std::mutex > lock( completionGuard );
+				isComplete = true;
+				completed.notify_all();
+			}
+		#endif
+		std::shared_ptr< LibThreadIt::ThreadHandle > Launch( const ThreadAttributes& attributes, 
+				THREAD_ATOMIC_MANAGMENT managmentBehavior, std::shared_ptr< LibThreadIt::AtomicManager > atomicPool, 
+				std::shared_ptr< ThreadHandle > parent, JOIN_OR_DETACH threadBehavior, 
+				std::shared_ptr< CallItLater::AppliedProcedure > procedure )
+		{
+			#ifdef THREAD_IT_NACL_PLATFORM
+				std::shared_ptr< GoogleNativeClientThreadHandle > threadHandle;
+				if( parent )
+					threadHandle = MakeRecycled< GoogleNativeClientThreadHandle >( threadBehavior, parent, procedure );
+				else
+					threadHandle = MakeRecycled< GoogleNativeClientThreadHandle >( threadBehavior, procedure );
+			#endif
+			#ifdef THREAD_IT_POSIX_PLATFORM
+				std::shared_ptr< PosixTreeHandle > threadHandle;
+				if( attributes.launchMode == POOLED_THREAD )
+				{
+					std::shared_ptr< PooledThreadHandle > pooledHandle;
+					if( parent )
+						pooledHandle = MakeRecycled< PooledThreadHandle >( threadBehavior, parent, procedure );
+					else
+						pooledHandle = MakeRecycled< PooledThreadHandle >( threadBehavior, procedure );
+					if( threadBehavior == DETACH )
+						pooledHandle->SetKeepAlive( pooledHandle );
+					threadHandle = pooledHandle;
+				}
+				else
+				{
+					std::shared_ptr< PosixThreadHandle > posixHandle;
+					if( parent )
+						posixHandle = MakeRecycled< PosixThreadHandle >( threadBehavior, parent, procedure );
+					else
+						posixHandle = MakeRecycled< PosixThreadHandle >( threadBehavior, procedure );
+					if( threadBehavior == DETACH )
+						posixHandle->SetKeepAlive( posixHandle );
+					threadHandle = posixHandle;
+				}
+			#endif
+			threadHandle->SetAttributes( attributes );
+			threadHandle->SetManagmentBehavior( managmentBehavior );
+			threadHandle->SetAtomicPool( atomicPool );
+			threadHandle->Run();
+			return threadHandle;
+		}
+	}
+	namespace
+	{
+		const std::uint32_t NONE_FINISHED = UINT32_MAX;
+		/*What WaitAll and WaitAny sleep on, shared with the completion callbacks 
+		since those outlive a wait that timed out.*/
+		struct WaitState
+		{
+			//Handles WaitAll is still waiting for.//
+			std::atomic< std::uint32_t > remaining;
+			//Index of the first handle WaitAny saw finish.//
+			std::atomic< std::uint32_t > firstFinished;
+			explicit WaitState( std::uint32_t remaining_ ) : remaining( remaining_ ), 
+					firstFinished( NONE_FINISHED ) {
+			}
+		};
+		typedef std::vector< std::pair< LibThreadIt::ThreadHandle*, 
+				Implementation::CompletionList::REGISTRATION > > REGISTRATIONS;
+		//A wait that is over, either way, leaves no callbacks behind on handles still running.//
+		void RemoveRegistrations( const REGISTRATIONS& registrations )
+		{
+			const std::size_t AMOUNT_OF_REGISTRATIONS = registrations.size();
+			for( std::size_t i = 0; i < AMOUNT_OF_REGISTRATIONS; ++i )
+				registrations[ i ].first->RemoveCompletion( registrations[ i ].second );
+		}
+		/*Sleeps on "word" until "isDone" holds for it, false if "timeout" (when there is 
+		one) ran out first.*/
+		template< typename IS_DONE_T >
+		bool AwaitWord( std::atomic< std::uint32_t >& word, IS_DONE_T isDone, 
+				const std::chrono::nanoseconds* timeout )
+		{
+			const std::chrono::steady_clock::time_point START = std::chrono::steady_clock::now();
+			#ifdef THREAD_IT_POSIX_PLATFORM
+				//A worker waiting on the pool keeps it moving instead of sleeping.//
+				Implementation::WorkerPool& pool = Implementation::WorkerPool::Global();
+			#endif
+			while( true )
+			{
+				const std::uint32_t OBSERVED = word.load( std::memory_order_acquire );
+				if( isDone( OBSERVED ) == true )
+					return ( true );
+				std::chrono::nanoseconds left( 0 );
+				if( timeout != nullptr ) {
+					left = *timeout - std::chrono::duration_cast< std::chrono::nanoseconds >( 
+							std::chrono::steady_clock::now() - START );
+					if( left.count() <= 0 )
+						return ( false );
+				}
+				#ifdef THREAD_IT_POSIX_PLATFORM
+					if( pool.IsWorkerThread() == true ) {
+						if( pool.RunPendingTask() == false )
+							std::this_thread::yield();
+						continue;
+					}
+				#endif
+				if( timeout == nullptr )
+					Implementation::ParkOnAddress( &word, OBSERVED );
+				else
+					Implementation::ParkOnAddressFor( &word, OBSERVED, left.count() );
+			}
+		}
+		bool WaitAllWithin( const std::vector< std::shared_ptr< LibThreadIt::ThreadHandle > >& handles, 
+				const std::chrono::nanoseconds* timeout )
+		{
+			std::uint32_t amountOfHandles = 0;
+			bool isAllComplete = true;
+			const std::size_t AMOUNT_OF_HANDLES = handles.size();
+			for( std::size_t i = 0; i < AMOUNT_OF_HANDLES; ++i )
+			{
+				if( !handles[ i ] )
+					continue;
+				++amountOfHandles;
+				if( handles[ i ]->IsComplete() == false )
+					isAllComplete = false;
+			}
+			if( isAllComplete == true )
+				return ( true );
+			//The extra count is ours, so nothing wakes us before every callback is in.//
+			std::shared_ptr< WaitState > state = std::make_shared< WaitState >( amountOfHandles + 1 );
+			REGISTRATIONS registrations;
+			registrations.reserve( amountOfHandles );
+			for( std::size_t i = 0; i < AMOUNT_OF_HANDLES; ++i )
+			{
+				if( !handles[ i ] )
+					continue;
+				if( handles[ i ]->IsComplete() == true ) {
+					state->remaining.fetch_sub( 1, std::memory_order_relaxed );
+					continue;
+				}
+				//Only the last one to finish wakes the waiter.//
+				registrations.push_back( std::make_pair( handles[ i ].get(), handles[ i ]->OnCompletion( [ state ]() {
+					if( state->remaining.fetch_sub( 1, std::memory_order_acq_rel ) == 1 )
+						Implementation::WakeAddress( &state->remaining, true );
+				} ) ) );
+			}
+			if( state->remaining.fetch_sub( 1, std::memory_order_acq_rel ) == 1 )
+				return ( true );
+			const bool IS_ALL_COMPLETE = AwaitWord( state->remaining, []( std::uint32_t remaining ) { 
+					return ( remaining == 0 ); }, timeout );
+			if( IS_ALL_COMPLETE == false )
+				RemoveRegistrations( registrations );
+			return ( IS_ALL_COMPLETE );
+		}
+		std::size_t WaitAnyWithin( const std::vector< std::shared_ptr< LibThreadIt::ThreadHandle > >& handles, 
+				const std::chrono::nanoseconds* timeout )
+		{
+			bool hasHandle = false;
+			const std::size_t AMOUNT_OF_HANDLES = handles.size();
+			for( std::size_t i = 0; i < AMOUNT_OF_HANDLES; ++i )
+			{
+				if( !handles[ i ] )
+					continue;
+				if( handles[ i ]->IsComplete() == true )
+					return ( i );
+				hasHandle = true;
+			}
+			if( hasHandle == false )
+				return ( AMOUNT_OF_HANDLES );
+			std::shared_ptr< WaitState > state = std::make_shared< WaitState >( 0 );
+			REGISTRATIONS registrations;
+			registrations.reserve( AMOUNT_OF_HANDLES );
+			for( std::size_t i = 0; i < AMOUNT_OF_HANDLES; ++i )
+			{
+				if( !handles[ i ] )
+					continue;
+				const std::uint32_t INDEX = i;
+				registrations.push_back( std::make_pair( handles[ i ].get(), handles[ i ]->OnCompletion( [ state, INDEX ]() {
+					std::uint32_t none = NONE_FINISHED;
+					if( state->firstFinished.compare_exchange_strong( none, INDEX, std::memory_order_acq_rel ) == true )
+						Implementation::WakeAddress( &state->firstFinished, true );
+				} ) ) );
+				//Already done, no need to register on the rest.//
+				if( state->firstFinished.load( std::memory_order_acquire ) != NONE_FINISHED )
+					break;
+			}
+			const bool HAS_FINISHED = AwaitWord( state->firstFinished, []( std::uint32_t first ) { 
+					return ( first != NONE_FINISHED ); }, timeout );
+			//Only one handle had to finish, the rest may run for a long time yet.//
+			RemoveRegistrations( registrations );
+			if( HAS_FINISHED == false )
+				return ( AMOUNT_OF_HANDLES );
+			return ( state->firstFinished.load( std::memory_order_acquire ) );
+		}
+	}
+	void WaitAll( const std::vector< std::shared_ptr< LibThreadIt::ThreadHandle > >& handles ) {
+		WaitAllWithin( handles, nullptr );
+	}
+	bool WaitAllFor( const std::vector< std::shared_ptr< LibThreadIt::ThreadHandle > >& handles, 
+			std::chrono::nanoseconds timeout ) {
+		return WaitAllWithin( handles, &timeout );
+	}
+	std::size_t WaitAny( const std::vector< std::shared_ptr< LibThreadIt::ThreadHandle > >& handles ) {
+		return WaitAnyWithin( handles, nullptr );
+	}
+	std::size_t WaitAnyFor( const std::vector< std::shared_ptr< LibThreadIt::ThreadHandle > >& handles, 
+			std::chrono::nanoseconds timeout ) {
+		return WaitAnyWithin( handles, &timeout );
 	}
 }
@@ -11,7 +11,19 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, 
 WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 */
+#pragma once
+#include <chrono>
 #include <AtomicResource.h>
+#include <AtomicPool.h>
+#include <WorkerPool.h>
+#include <Future.h>
+#include <Task.h>
+#include <Parallel.h>
+#include <Batch.h>
+#include <Coroutine.h>
+#include <Channel.h>
+#include <VersionedAtomic.h>
+#include <Timer.h>
 
 namespace LibThreadIt
 {
@@ -24,6 +36,54 @@ namespace LibThreadIt
 		AQUIRE_ALL_ON_START = 0, 
 		DO_NOT_AQUIRE_ALL_ON_START = 1
 	};
+	enum THREAD_LAUNCH_MODE {
+		//A new OS thread per launch.//
+		OS_THREAD = 0, 
+		//Queued on the long lived worker pool, falls back to OS_THREAD where there is no pool.//
+		POOLED_THREAD = 1
+	};
+	/*How the threads launched into one tree run against each other. SERIALIZE_TREE 
+	is the default, it is what ThreadAttributes() and every overload without 
+	attributes use, so a tree only runs in parallel when the root and each launch 
+	set "treeBehavior" to CONCURRENT_TREE.*/
+	enum THREAD_TREE_BEHAVIOR {
+		/*One thread per tree runs at a time, the next one starts when it finishes. 
+		A pooled launch into a busy tree returns right away and is queued. A thread 
+		in the tree must not join a child it launched into the same tree, the child 
+		can not start until the thread itself finishes.*/
+		SERIALIZE_TREE = 0, 
+		/*Siblings run side by side, only the Atomics a thread aquires keep it from 
+		racing the others. With AQUIRE_ALL_ON_START each launch holds the atomics 
+		already in its pool when it starts, so siblings that share those wait for 
+		each other. Atomics branched later lock on their own when aquired.*/
+		CONCURRENT_TREE = 1
+	};
+	/*Options applied to the OS thread when it is created, back ends that can not 
+	honor an option ignore it.*/
+	struct ThreadAttributes
+	{
+		//CPUs the thread may run on, empty means no restriction.//
+		std::vector< int > cpuAffinity;
+		//Stack size in bytes, zero keeps the platform default.//
+		std::size_t stackSize;
+		//Shown by top and perf, Linux truncates it to 15 characters.//
+		std::string name;
+		/*Pooled tasks run on threads the pool owns, so the options above do not 
+		apply to them.*/
+		THREAD_LAUNCH_MODE launchMode;
+		//SERIALIZE_TREE unless changed, see THREAD_TREE_BEHAVIOR.//
+		THREAD_TREE_BEHAVIOR treeBehavior;
+		/*Orders pooled tasks, see THREAD_PRIORITY. An OS thread only honors 
+		BACKGROUND_PRIORITY, raising a thread's priority takes privileges.*/
+		THREAD_PRIORITY priority;
+		/*When a pooled task should be done by, time_point::max() for no deadline. 
+		The pool counts the misses, see WorkerPool::GetDeadlineStats().*/
+		std::chrono::steady_clock::time_point deadline;
+		explicit ThreadAttributes() : stackSize( 0 ), launchMode( OS_THREAD ), 
+				treeBehavior( SERIALIZE_TREE ), priority( NORMAL_PRIORITY ), 
+				deadline( std::chrono::steady_clock::time_point::max() ) {
+		}
+	};
 	struct ThreadHandle : public LibThreadIt::MacroAtomic
 	{
 		virtual void Join() = 0;
@@ -33,11 +93,22 @@ namespace LibThreadIt
 		virtual bool ResultIsValid() = 0;
 		//Is any data on the thread, not being volitile right now?//
 		virtual bool DataIsSafe() = 0;
-		virtual void AquireAll() {
-			atomicPool->AquireAll();
+		/*The hold belongs to this launch and covers the atomics the pool had when it 
+		was taken. Siblings in a CONCURRENT_TREE wait on each other for those, not 
+		for the pool as a whole.*/
+		virtual void AquireAll()
+		{
+			if( poolHold.IsHeld() == false )
+				poolHold = atomicPool->Hold();
+		}
+		virtual bool TryAquireAll()
+		{
+			if( poolHold.IsHeld() == true )
+				return ( true );
+			return atomicPool->TryHold( poolHold );
 		}
 		virtual void ReleaseAll() {
-			atomicPool->ReleaseAll();
+			poolHold.Release();
 		}
 		template< typename RETURN_DATA_T >
 		auto GetResult() -> RETURN_DATA_T {
@@ -69,11 +140,51 @@ namespace LibThreadIt
 		void SetProcedureToRun( std::shared_ptr< CallItLater::AppliedProcedure > procedureToRun_ ) {
 			procedureToRun = procedureToRun_;
 		}
+		ThreadAttributes GetAttributes() {
+			return attributes;
+		}
+		//Only takes effect if called before the thread is started.//
+		void SetAttributes( const ThreadAttributes& attributes_ ) {
+			attributes = attributes_;
+		}
+		//Does this thread hold the tree's mutex while it runs?//
+		bool SerializesTree() {
+			return ( attributes.treeBehavior == SERIALIZE_TREE );
+		}
+		/*Runs "callback" on the finishing thread once the procedure is done and its 
+		result is valid, or right away if that already happened.*/
+		Implementation::CompletionList::REGISTRATION OnCompletion( std::function< void() > callback ) {
+			return completion.Add( callback );
+		}
+		//Takes back a callback from OnCompletion, 'false' if it already ran or is running.//
+		bool RemoveCompletion( Implementation::CompletionList::REGISTRATION registration ) {
+			return completion.Remove( registration );
+		}
+		//Called by the back ends, the procedure has run and the data is safe.//
+		void SignalCompletion() {
+			completion.Complete();
+		}
+		bool IsComplete() {
+			return completion.IsComplete();
+		}
+		/*Runs the procedure on the thread it was launched on. Atomics it branches 
+		from the pool while this launch holds it are covered by that hold, if the 
+		hold took their lock words.*/
+		void ExecuteProcedure()
+		{
+			Implementation::HeldOnThisThread covered( 
+					( poolHold.IsHeld() == true ) ? &poolHold : nullptr );
+			procedureToRun->ExecuteFunction();
+		}
 		protected: 
 			THREAD_ATOMIC_MANAGMENT managmentBehavior;
+			ThreadAttributes attributes;
 			std::shared_ptr< LibThreadIt::AtomicManager > atomicPool;
 			//The procedure to run.//
 			std::shared_ptr< CallItLater::AppliedProcedure > procedureToRun;
+			Implementation::CompletionList completion;
+			//Taken by AquireAll for this launch, given back by ReleaseAll.//
+			PoolHold poolHold;
 	};
 	namespace Implementation
 	{
@@ -172,7 +283,7 @@ namespace LibThreadIt
 						threadBehavior( threadBehavior_ )
 				{
 					//Begin the tree.//
-					stateGuard = std::make_shared< GoogleNativeClientMutex >();
+					stateGuard = MakeRecycled< GoogleNativeClientMutex >();
 					//Prepare the mutex.//
 					stateGuard->Initialize();
 					dataIsSafe = true;
@@ -190,14 +301,16 @@ namespace LibThreadIt
 				virtual void Join()
 				{
 					pthread_join( threadHandle, NULL );
-					stateGuard->UnLock();
+					if( SerializesTree() == true )
+						stateGuard->UnLock();
 					dataIsSafe = true;
 				}
 				//Clean up everything, and update the state.//
 				virtual void Detach()
 				{
 					pthread_detach( threadHandle );
-					stateGuard->UnLock();
+					if( SerializesTree() == true )
+						stateGuard->UnLock();
 					dataIsSafe = true;
 				}
 				virtual bool DataIsSafe() {
@@ -215,10 +328,13 @@ namespace LibThreadIt
 						stateGuard->Initialize();
 					/*Has it been locked before? If so, is another thread running, catch the first "ride, " 
 					after another thread is finished.*/
-					if( stateGuard->GetWasLocked() == false )
-						stateGuard->Lock();
-					else
-						while( stateGuard->TryLock() == false );
+					if( SerializesTree() == true )
+					{
+						if( stateGuard->GetWasLocked() == false )
+							stateGuard->Lock();
+						else
+							while( stateGuard->TryLock() == false );
+					}
 					if( managmentBehavior == AQUIRE_ALL_ON_START )
 						AquireAll();
 					//Start the thread!//
@@ -228,7 +344,7 @@ namespace LibThreadIt
 				/*Execute the function on the thread, ANYTHING that needs to be protected is inside this function, 
 				hence, when it is finished, all reasources can be released.*/
 				void RunOnThread() {
-					procedureToRun->ExecuteFunction();
+					ExecuteProcedure();
 				}
 				virtual bool ResultIsValid() {
 					return dataIsSafe.load( std::memory_order_acquire );
@@ -253,20 +369,323 @@ namespace LibThreadIt
 					pthread_t threadHandle;
 			};
 		#endif
+		#ifdef THREAD_IT_POSIX_PLATFORM
+			/*Unlike a pthread mutex this may be unlocked from a different thread than the one 
+			that locked it, the tree is locked by the launching thread and unlocked by the 
+			launched thread. Pooled launches and batches never wait for it, they queue and 
+			are started by the UnLock that hands the tree to them.*/
+			class PosixMutex
+			{
+				std::mutex stateGuard;
+				std::condition_variable unlocked;
+				bool isLocked;
+				//Pooled launches and batches waiting for the tree, first come first served.//
+				std::deque< TreeWaiter* > queued;
+				public: 
+					explicit PosixMutex() : isLocked( false ) {
+					}
+					//A worker keeps running tasks while it waits, the holder may be one of them.//
+					void Lock()
+					{
+						WorkerPool& pool = WorkerPool::Global();
+						if( pool.IsWorkerThread() == true )
+						{
+							while( TryLock() == false )
+								if( pool.RunPendingTask() == false )
+									std::this_thread::yield();
+							return;
+						}
+						std::unique_lock< std::mutex > lock( stateGuard );
+						unlocked.wait( lock, [ this ]() { return ( isLocked == false ); } );
+						isLocked = true;
+					}
+					/*'true' if the tree is now locked for "waiter, " otherwise it is queued and 
+					takes its turn once the tree is handed to it.*/
+					bool LockOrQueue( TreeWaiter* waiter )
+					{
+						std::lock_guard< std::mutex > lock( stateGuard );
+						if( isLocked == false ) {
+							isLocked = true;
+							return ( true );
+						}
+						queued.push_back( waiter );
+						return ( false );
+					}
+					//'true' = did lock, 'false' = did not lock.//
+					bool TryLock()
+					{
+						std::lock_guard< std::mutex > lock( stateGuard );
+						if( isLocked == true )
+							return ( false );
+						isLocked = true;
+						return ( true );
+					}
+					/*'true' for success 'false' for failure. Hands the tree to the first queued 
+					waiter, if there is one, without unlocking it in between.*/
+					bool UnLock()
+					{
+						TreeWaiter* next = nullptr;
+						{
+							std::lock_guard< std::mutex > lock( stateGuard );
+							if( isLocked == false )
+								return ( false );
+							if( queued.empty() == true )
+								isLocked = false;
+							else {
+								next = queued.front();
+								queued.pop_front();
+							}
+						}
+						if( next != nullptr )
+							next->TakeTurn();
+						else
+							unlocked.notify_one();
+						return ( true );
+					}
+					bool GetIsLocked() {
+						std::lock_guard< std::mutex > lock( stateGuard );
+						return isLocked;
+					}
+			};
+			typedef std::shared_ptr< PosixMutex > SHARED_MUTEX;
+			typedef PosixMutex MUTEX;
+			void* PosixRunOnThread( void* threadHandle );
+			//What every POSIX handle in a tree has in common.//
+			struct PosixTreeHandle : public LibThreadIt::ThreadHandle
+			{
+				explicit PosixTreeHandle( JOIN_OR_DETACH threadBehavior_, 
+						std::shared_ptr< ThreadHandle > root, 
+						std::shared_ptr< CallItLater::AppliedProcedure > callItLaterProcedure ) : 
+						threadBehavior( threadBehavior_ )
+				{
+					//Continue the tree, siblings share the root's mutex.//
+					auto castedRoot = ( ( PosixTreeHandle* ) root.get() );
+					stateGuard = castedRoot->GetStateGuard();
+					dataIsSafe = true;
+					procedureToRun = callItLaterProcedure;
+				}
+				explicit PosixTreeHandle( JOIN_OR_DETACH threadBehavior_, 
+						std::shared_ptr< CallItLater::AppliedProcedure > callItLaterProcedure ) : 
+						threadBehavior( threadBehavior_ )
+				{
+					//Begin the tree.//
+					stateGuard = MakeRecycled< PosixMutex >();
+					dataIsSafe = true;
+					procedureToRun = callItLaterProcedure;
+				}
+				virtual void Run() = 0;
+				virtual bool DataIsSafe() {
+					return dataIsSafe.load( std::memory_order_acquire );
+				}
+				void SetDataIsSafe( bool dataIsSafe_ ) {
+					dataIsSafe.store( dataIsSafe_, std::memory_order_release );
+				}
+				virtual bool ResultIsValid() {
+					return dataIsSafe.load( std::memory_order_acquire );
+				}
+				template< typename CLASS_T >
+				void SetClassInstance( CLASS_T* classInstance ) {
+					auto appliedMethodToRun = ( ( CallItLater::AppliedMethod< CLASS_T >* ) procedureToRun.get() );
+					appliedMethodToRun->SetInstance( classInstance );
+				}
+				SHARED_MUTEX GetStateGuard() {
+					return stateGuard;
+				}
+				protected: 
+					JOIN_OR_DETACH threadBehavior;
+					std::atomic< bool > dataIsSafe;
+					SHARED_MUTEX stateGuard;
+			};
+			struct PosixThreadHandle : public PosixTreeHandle
+			{
+				explicit PosixThreadHandle( JOIN_OR_DETACH threadBehavior_, 
+						std::shared_ptr< ThreadHandle > root, 
+						std::shared_ptr< CallItLater::AppliedProcedure > callItLaterProcedure ) : 
+						PosixTreeHandle( threadBehavior_, root, callItLaterProcedure ), isJoinable( false ) {
+				}
+				explicit PosixThreadHandle( JOIN_OR_DETACH threadBehavior_, 
+						std::shared_ptr< CallItLater::AppliedProcedure > callItLaterProcedure ) : 
+						PosixTreeHandle( threadBehavior_, callItLaterProcedure ), isJoinable( false ) {
+				}
+				~PosixThreadHandle()
+				{
+					if( threadBehavior == JOIN )
+						Join();
+					else
+						Detach();
+				}
+				virtual void Join()
+				{
+					if( isJoinable == true )
+					{
+						isJoinable = false;
+						/*The last reference to a detached handle is dropped on its own thread, 
+						joining there would deadlock.*/
+						if( pthread_equal( pthread_self(), threadHandle ) != 0 )
+							pthread_detach( threadHandle );
+						else
+							pthread_join( threadHandle, NULL );
+					}
+				}
+				virtual void Detach()
+				{
+					if( isJoinable == true ) {
+						isJoinable = false;
+						pthread_detach( threadHandle );
+					}
+				}
+				virtual void Run()
+				{
+					dataIsSafe.store( false, std::memory_order_release );
+					//Wait for the thread before us in the tree to finish.//
+					if( SerializesTree() == true )
+						stateGuard->Lock();
+					if( managmentBehavior == AQUIRE_ALL_ON_START )
+						AquireAll();
+					pthread_attr_t threadAttributes;
+					pthread_attr_init( &threadAttributes );
+					if( attributes.stackSize != 0 )
+						pthread_attr_setstacksize( &threadAttributes, attributes.stackSize );
+					#ifdef __linux__
+						if( attributes.cpuAffinity.empty() == false )
+						{
+							cpu_set_t cpus;
+							CPU_ZERO( &cpus );
+							const unsigned int AMOUNT_OF_CPUS = attributes.cpuAffinity.size();
+							for( unsigned int i = 0; i < AMOUNT_OF_CPUS; ++i )
+								CPU_SET( attributes.cpuAffinity[ i ], &cpus );
+							pthread_attr_setaffinity_np( &threadAttributes, sizeof( cpus ), &cpus );
+						}
+					#endif
+					isJoinable = ( pthread_create( &threadHandle, &threadAttributes, 
+							&PosixRunOnThread, ( ( void* ) this ) ) == 0 );
+					pthread_attr_destroy( &threadAttributes );
+					if( isJoinable == false )
+					{
+						//Never started, undo everything the thread would have undone.//
+						keepAlive.reset();
+						if( SerializesTree() == true )
+							stateGuard->UnLock();
+						if( managmentBehavior == AQUIRE_ALL_ON_START )
+							ReleaseAll();
+						dataIsSafe.store( true, std::memory_order_release );
+					}
+				}
+				void RunOnThread()
+				{
+					//Named from the inside so the name is in place before any work is done.//
+					#ifdef __linux__
+						if( attributes.name.empty() == false )
+							pthread_setname_np( pthread_self(), attributes.name.substr( 0, 15 ).c_str() );
+						//Lowering our own policy needs no privileges, so this does not fail in practice.//
+						if( attributes.priority == BACKGROUND_PRIORITY ) {
+							sched_param parameters;
+							parameters.sched_priority = 0;
+							pthread_setschedparam( pthread_self(), SCHED_IDLE, &parameters );
+						}
+					#endif
+					ExecuteProcedure();
+				}
+				/*Detached threads outlive the caller's handle, so they hold on to it until 
+				the procedure is done.*/
+				void SetKeepAlive( std::shared_ptr< PosixThreadHandle > keepAlive_ ) {
+					keepAlive = keepAlive_;
+				}
+				std::shared_ptr< PosixThreadHandle > TakeKeepAlive() {
+					std::shared_ptr< PosixThreadHandle > taken;
+					taken.swap( keepAlive );
+					return taken;
+				}
+				protected: 
+					pthread_t threadHandle;
+					bool isJoinable;
+					std::shared_ptr< PosixThreadHandle > keepAlive;
+			};
+			/*Runs on the global WorkerPool instead of its own thread, joining waits for the 
+			task to finish rather than for a thread to exit.*/
+			struct PooledThreadHandle : public PosixTreeHandle, public PoolTask, public TreeWaiter
+			{
+				explicit PooledThreadHandle( JOIN_OR_DETACH threadBehavior_, 
+						std::shared_ptr< ThreadHandle > root, 
+						std::shared_ptr< CallItLater::AppliedProcedure > callItLaterProcedure ) : 
+						PosixTreeHandle( threadBehavior_, root, callItLaterProcedure ), isComplete( true ) {
+				}
+				explicit PooledThreadHandle( JOIN_OR_DETACH threadBehavior_, 
+						std::shared_ptr< CallItLater::AppliedProcedure > callItLaterProcedure ) : 
+						PosixTreeHandle( threadBehavior_, callItLaterProcedure ), isComplete( true ) {
+				}
+				~PooledThreadHandle()
+				{
+					//A detached task keeps itself alive, so only joined tasks can get here early.//
+					if( threadBehavior == JOIN )
+						Join();
+				}
+				virtual void Join()
+				{
+					//A worker waiting on a task keeps running other tasks, it might be the one we need.//
+					WorkerPool& pool = WorkerPool::Global();
+					if( pool.IsWorkerThread() == true )
+					{
+						while( true )
+						{
+							{
+								std::lock_guard< std::mutex > lock( completionGuard );
+								if( isComplete == true )
+									return;
+							}
+							if( pool.RunPendingTask() == false )
+								std::this_thread::yield();
+						}
+					}
+					std::unique_lock< std::mutex > lock( completionGuard );
+					completed.wait( lock, [ this ]() { return isComplete; } );
+				}
+				virtual void Detach() {
+				}
+				/*A busy tree does not hold up the caller, which may be a worker, the launch 
+				waits in the tree's queue and aquires on the worker once it is its turn.*/
+				virtual void Run()
+				{
+					dataIsSafe.store( false, std::memory_order_release );
+					isComplete = false;
+					if( SerializesTree() == true && stateGuard->LockOrQueue( this ) == false )
+						return;
+					if( managmentBehavior == AQUIRE_ALL_ON_START )
+						AquireAll();
+					SubmitToPool();
+				}
+				void SubmitToPool() {
+					WorkerPool::Global().Submit( this, attributes.priority, attributes.deadline );
+				}
+				virtual void TakeTurn() {
+					SubmitToPool();
+				}
+				virtual void RunOnWorker();
+				void SetKeepAlive( std::shared_ptr< PooledThreadHandle > keepAlive_ ) {
+					keepAlive = keepAlive_;
+				}
+				protected: 
+					std::mutex completionGuard;
+					std::condition_variable completed;
+					bool isComplete;
+					std::shared_ptr< PooledThreadHandle > keepAlive;
+			};
+		#endif
+		/*Makes the handle for the current back end, ready to run "procedure, " and starts it. 
+		A null "parent" begins a new tree.*/
+		std::shared_ptr< LibThreadIt::ThreadHandle > Launch( const ThreadAttributes& attributes, 
+				THREAD_ATOMIC_MANAGMENT managmentBehavior, std::shared_ptr< LibThreadIt::AtomicManager > atomicPool, 
+				std::shared_ptr< ThreadHandle > parent, JOIN_OR_DETACH threadBehavior, 
+				std::shared_ptr< CallItLater::AppliedProcedure > procedure );
 	}
 	//To get a root.//
 	template< typename RETURN_TYPE_T, typename... ARGUMENTS_T >
 	std::shared_ptr< LibThreadIt::ThreadHandle > ThreadItInitialize( THREAD_ATOMIC_MANAGMENT managmentBehavior, 
 			JOIN_OR_DETACH threadBehavior, RETURN_TYPE_T(* functionToRun )( ARGUMENTS_T... ), ARGUMENTS_T... arguments )
 	{
-		#ifdef THREAD_IT_NACL_PLATFORM
-			auto threadHandle = std::make_shared< LibThreadIt::Implementation::GoogleNativeClientThreadHandle >( 
-					threadBehavior, CallItLater::MakeAppliedProcedure< RETURN_TYPE_T, ARGUMENTS_T... >( functionToRun, arguments... ) );
-			threadHandle->SetManagmentBehavior( managmentBehavior );
-			threadHandle->SetAtomicPool( std::make_shared< LibThreadIt::AtomicManager >() );
-			threadHandle->Run();
-			return threadHandle;
-		#endif
+		return Implementation::Launch( ThreadAttributes(), managmentBehavior, 
+				LibThreadIt::MakeAtomicResource(), nullptr, threadBehavior, 
+				CallItLater::MakeAppliedProcedure< RETURN_TYPE_T, ARGUMENTS_T... >( functionToRun, arguments... ) );
 	}
 	//To continue the tree.//
 	template< typename RETURN_TYPE_T, typename... ARGUMENTS_T >
@@ -274,15 +693,9 @@ namespace LibThreadIt
 			std::shared_ptr< ThreadHandle > parent, JOIN_OR_DETACH threadBehavior, 
 			RETURN_TYPE_T(* functionToRun )( ARGUMENTS_T... ), ARGUMENTS_T... arguments )
 	{
-		#ifdef THREAD_IT_NACL_PLATFORM
-			auto threadHandle = std::make_shared< LibThreadIt::Implementation::GoogleNativeClientThreadHandle >( 
-					threadBehavior, parent, 
-					CallItLater::MakeAppliedProcedure< RETURN_TYPE_T, ARGUMENTS_T... >( functionToRun, arguments... ) );
-			threadHandle->SetManagmentBehavior( managmentBehavior );
-			threadHandle->SetAtomicPool( std::make_shared< LibThreadIt::AtomicManager >() );
-			threadHandle->Run();
-			return threadHandle;
-		#endif
+		return Implementation::Launch( ThreadAttributes(), managmentBehavior, 
+				LibThreadIt::MakeAtomicResource(), parent, threadBehavior, 
+				CallItLater::MakeAppliedProcedure< RETURN_TYPE_T, ARGUMENTS_T... >( functionToRun, arguments... ) );
 	}
 	template< typename CLASS_T, typename RETURN_TYPE_T, typename... ARGUMENTS_T >
 	std::shared_ptr< LibThreadIt::ThreadHandle > MethodThreadItInitialize( THREAD_ATOMIC_MANAGMENT managmentBehavior, 
@@ -290,45 +703,69 @@ namespace LibThreadIt
 			RETURN_TYPE_T(CLASS_T::* methodToRun )( ARGUMENTS_T... ), 
 			ARGUMENTS_T... arguments )
 	{
-		#ifdef THREAD_IT_NACL_PLATFORM
-			auto threadHandle = std::make_shared< LibThreadIt::Implementation::GoogleNativeClientThreadHandle >( 
-					threadBehavior, CallItLater::MakeAppliedMethod< CLASS_T, RETURN_TYPE_T, ARGUMENTS_T... >( 
-					classInstance, methodToRun, arguments... ) );
-			threadHandle->SetManagmentBehavior( managmentBehavior );
-			threadHandle->SetAtomicPool( std::make_shared< LibThreadIt::AtomicManager >() );
-			threadHandle->Run();
-			return threadHandle;
-		#endif
+		return Implementation::Launch( ThreadAttributes(), managmentBehavior, 
+				LibThreadIt::MakeAtomicResource(), nullptr, threadBehavior, 
+				CallItLater::MakeAppliedMethod< CLASS_T, RETURN_TYPE_T, ARGUMENTS_T... >( 
+				classInstance, methodToRun, arguments... ) );
 	}
 	template< typename CLASS_T, typename RETURN_TYPE_T, typename... ARGUMENTS_T >
 	std::shared_ptr< LibThreadIt::ThreadHandle > MethodThreadIt( THREAD_ATOMIC_MANAGMENT managmentBehavior, 
 			std::shared_ptr< ThreadHandle > parent, CLASS_T* classInstance, JOIN_OR_DETACH threadBehavior, 
 			RETURN_TYPE_T(CLASS_T::* methodToRun )( ARGUMENTS_T... ), ARGUMENTS_T... arguments )
 	{
-		#ifdef THREAD_IT_NACL_PLATFORM
-			auto threadHandle = std::make_shared< LibThreadIt::Implementation::GoogleNativeClientThreadHandle >( 
-					threadBehavior, parent, 
-					CallItLater::MakeAppliedMethod< CLASS_T, RETURN_TYPE_T, ARGUMENTS_T... >( 
-					classInstance, methodToRun, arguments... ) );
-			threadHandle->SetManagmentBehavior( managmentBehavior );
-			threadHandle->SetAtomicPool( std::make_shared< LibThreadIt::AtomicManager >() );
-			threadHandle->Run();
-			return threadHandle;
-		#endif
+		return Implementation::Launch( ThreadAttributes(), managmentBehavior, 
+				LibThreadIt::MakeAtomicResource(), parent, threadBehavior, 
+				CallItLater::MakeAppliedMethod< CLASS_T, RETURN_TYPE_T, ARGUMENTS_T... >( 
+				classInstance, methodToRun, arguments... ) );
+	}
+	//Same as above, but the OS thread is set up with "attributes."//
+	template< typename RETURN_TYPE_T, typename... ARGUMENTS_T >
+	std::shared_ptr< LibThreadIt::ThreadHandle > ThreadItInitialize( const ThreadAttributes& attributes, 
+			THREAD_ATOMIC_MANAGMENT managmentBehavior, JOIN_OR_DETACH threadBehavior, 
+			RETURN_TYPE_T(* functionToRun )( ARGUMENTS_T... ), ARGUMENTS_T... arguments )
+	{
+		return Implementation::Launch( attributes, managmentBehavior, 
+				LibThreadIt::MakeAtomicResource(), nullptr, threadBehavior, 
+				CallItLater::MakeAppliedProcedure< RETURN_TYPE_T, ARGUMENTS_T... >( functionToRun, arguments... ) );
+	}
+	template< typename RETURN_TYPE_T, typename... ARGUMENTS_T >
+	std::shared_ptr< LibThreadIt::ThreadHandle > ThreadIt( const ThreadAttributes& attributes, 
+			THREAD_ATOMIC_MANAGMENT managmentBehavior, std::shared_ptr< ThreadHandle > parent, 
+			JOIN_OR_DETACH threadBehavior, RETURN_TYPE_T(* functionToRun )( ARGUMENTS_T... ), ARGUMENTS_T... arguments )
+	{
+		return Implementation::Launch( attributes, managmentBehavior, 
+				LibThreadIt::MakeAtomicResource(), parent, threadBehavior, 
+				CallItLater::MakeAppliedProcedure< RETURN_TYPE_T, ARGUMENTS_T... >( functionToRun, arguments... ) );
+	}
+	template< typename CLASS_T, typename RETURN_TYPE_T, typename... ARGUMENTS_T >
+	std::shared_ptr< LibThreadIt::ThreadHandle > MethodThreadItInitialize( const ThreadAttributes& attributes, 
+			THREAD_ATOMIC_MANAGMENT managmentBehavior, CLASS_T* classInstance, JOIN_OR_DETACH threadBehavior, 
+			RETURN_TYPE_T(CLASS_T::* methodToRun )( ARGUMENTS_T... ), ARGUMENTS_T... arguments )
+	{
+		return Implementation::Launch( attributes, managmentBehavior, 
+				LibThreadIt::MakeAtomicResource(), nullptr, threadBehavior, 
+				CallItLater::MakeAppliedMethod< CLASS_T, RETURN_TYPE_T, ARGUMENTS_T... >( 
+				classInstance, methodToRun, arguments... ) );
+	}
+	template< typename CLASS_T, typename RETURN_TYPE_T, typename... ARGUMENTS_T >
+	std::shared_ptr< LibThreadIt::ThreadHandle > MethodThreadIt( const ThreadAttributes& attributes, 
+			THREAD_ATOMIC_MANAGMENT managmentBehavior, std::shared_ptr< ThreadHandle > parent, 
+			CLASS_T* classInstance, JOIN_OR_DETACH threadBehavior, 
+			RETURN_TYPE_T(CLASS_T::* methodToRun )( ARGUMENTS_T... ), ARGUMENTS_T... arguments )
+	{
+		return Implementation::Launch( attributes, managmentBehavior, 
+				LibThreadIt::MakeAtomicResource(), parent, threadBehavior, 
+				CallItLater::MakeAppliedMethod< CLASS_T, RETURN_TYPE_T, ARGUMENTS_T... >( 
+				classInstance, methodToRun, arguments... ) );
 	}
 	//////////////////////////////
 		template< typename RETURN_TYPE_T, typename... ARGUMENTS_T >
 	std::shared_ptr< LibThreadIt::ThreadHandle > ThreadItInitializeWithPool( std::shared_ptr< LibThreadIt::AtomicManager > atomicPool, 
 			THREAD_ATOMIC_MANAGMENT managmentBehavior, JOIN_OR_DETACH threadBehavior, RETURN_TYPE_T(* functionToRun )( ARGUMENTS_T... ), ARGUMENTS_T... arguments )
 	{
-		#ifdef THREAD_IT_NACL_PLATFORM
-			auto threadHandle = std::make_shared< LibThreadIt::Implementation::GoogleNativeClientThreadHandle >( 
-					threadBehavior, CallItLater::MakeAppliedProcedure< RETURN_TYPE_T, ARGUMENTS_T... >( functionToRun, arguments... ) );
-			threadHandle->SetManagmentBehavior( managmentBehavior );
-			threadHandle->SetAtomicPool( LibThreadIt::MakeAtomicResource() );
-			threadHandle->Run();
-			return threadHandle;
-		#endif
+		return Implementation::Launch( ThreadAttributes(), managmentBehavior, 
+				atomicPool, nullptr, threadBehavior, 
+				CallItLater::MakeAppliedProcedure< RETURN_TYPE_T, ARGUMENTS_T... >( functionToRun, arguments... ) );
 	}
 	//To continue the tree.//
 	template< typename RETURN_TYPE_T, typename... ARGUMENTS_T >
@@ -337,15 +774,9 @@ namespace LibThreadIt
 			std::shared_ptr< ThreadHandle > parent, JOIN_OR_DETACH threadBehavior, 
 			RETURN_TYPE_T(* functionToRun )( ARGUMENTS_T... ), ARGUMENTS_T... arguments )
 	{
-		#ifdef THREAD_IT_NACL_PLATFORM
-			auto threadHandle = std::make_shared< LibThreadIt::Implementation::GoogleNativeClientThreadHandle >( 
-					threadBehavior, parent, 
-					CallItLater::MakeAppliedProcedure< RETURN_TYPE_T, ARGUMENTS_T... >( functionToRun, arguments... ) );
-			threadHandle->SetManagmentBehavior( managmentBehavior );
-			threadHandle->SetAtomicPool( LibThreadIt::MakeAtomicResource() );
-			threadHandle->Run();
-			return threadHandle;
-		#endif
+		return Implementation::Launch( ThreadAttributes(), managmentBehavior, 
+				atomicPool, parent, threadBehavior, 
+				CallItLater::MakeAppliedProcedure< RETURN_TYPE_T, ARGUMENTS_T... >( functionToRun, arguments... ) );
 	}
 	template< typename CLASS_T, typename RETURN_TYPE_T, typename... ARGUMENTS_T >
 	std::shared_ptr< LibThreadIt::ThreadHandle > MethodThreadItInitializeWithPool( 
@@ -354,15 +785,10 @@ namespace LibThreadIt
 			RETURN_TYPE_T(CLASS_T::* methodToRun )( ARGUMENTS_T... ), 
 			ARGUMENTS_T... arguments )
 	{
-		#ifdef THREAD_IT_NACL_PLATFORM
-			auto threadHandle = std::make_shared< LibThreadIt::Implementation::GoogleNativeClientThreadHandle >( 
-					threadBehavior, CallItLater::MakeAppliedMethod< CLASS_T, RETURN_TYPE_T, ARGUMENTS_T... >( 
-					classInstance, methodToRun, arguments... ) );
-			threadHandle->SetManagmentBehavior( managmentBehavior );
-			threadHandle->SetAtomicPool( LibThreadIt::MakeAtomicResource() );
-			threadHandle->Run();
-			return threadHandle;
-		#endif
+		return Implementation::Launch( ThreadAttributes(), managmentBehavior, 
+				atomicPool, nullptr, threadBehavior, 
+				CallItLater::MakeAppliedMethod< CLASS_T, RETURN_TYPE_T, ARGUMENTS_T... >( 
+				classInstance, methodToRun, arguments... ) );
 	}
 	template< typename CLASS_T, typename RETURN_TYPE_T, typename... ARGUMENTS_T >
 	std::shared_ptr< LibThreadIt::ThreadHandle > MethodThreadItWithPool( 
@@ -370,17 +796,81 @@ namespace LibThreadIt
 			std::shared_ptr< ThreadHandle > parent, CLASS_T* classInstance, JOIN_OR_DETACH threadBehavior, 
 			RETURN_TYPE_T(CLASS_T::* methodToRun )( ARGUMENTS_T... ), ARGUMENTS_T... arguments )
 	{
-		#ifdef THREAD_IT_NACL_PLATFORM
-			auto threadHandle = std::make_shared< LibThreadIt::Implementation::GoogleNativeClientThreadHandle >( 
-					threadBehavior, parent, 
-					CallItLater::MakeAppliedMethod< CLASS_T, RETURN_TYPE_T, ARGUMENTS_T... >( 
-					classInstance, methodToRun, arguments... ) );
-			threadHandle->SetManagmentBehavior( managmentBehavior );
-			threadHandle->SetAtomicPool( LibThreadIt::MakeAtomicResource() );
-			threadHandle->Run();
-			return threadHandle;
-		#endif
+		return Implementation::Launch( ThreadAttributes(), managmentBehavior, 
+				atomicPool, parent, threadBehavior, 
+				CallItLater::MakeAppliedMethod< CLASS_T, RETURN_TYPE_T, ARGUMENTS_T... >( 
+				classInstance, methodToRun, arguments... ) );
 	}
+	#ifdef THREAD_IT_POSIX_PLATFORM
+		namespace Implementation
+		{
+			template< typename RESULT_T >
+			struct HandleResult
+			{
+				static void Deliver( Promise< RESULT_T >& promise, std::shared_ptr< ThreadHandle > handle ) {
+					promise.SetValue( handle->GetResult< RESULT_T >() );
+				}
+			};
+			template<>
+			struct HandleResult< void >
+			{
+				static void Deliver( Promise< void >& promise, std::shared_ptr< ThreadHandle > ) {
+					promise.SetValue();
+				}
+			};
+		}
+		//A Future for the result of an already launched thread.//
+		template< typename RESULT_T >
+		Future< RESULT_T > FutureOf( std::shared_ptr< LibThreadIt::ThreadHandle > handle )
+		{
+			Promise< RESULT_T > promise;
+			Future< RESULT_T > future = promise.GetFuture();
+			//The handle is only held until it completes.//
+			handle->OnCompletion( [ promise, handle ]() mutable {
+				Implementation::HandleResult< RESULT_T >::Deliver( promise, handle );
+			} );
+			return future;
+		}
+		/*Runs "functionToRun" on the worker pool, alongside anything else, and hands back 
+		its result as a Future.*/
+		template< typename RETURN_TYPE_T, typename... ARGUMENTS_T >
+		Future< RETURN_TYPE_T > ThreadItFuture( THREAD_ATOMIC_MANAGMENT managmentBehavior, 
+				RETURN_TYPE_T(* functionToRun )( ARGUMENTS_T... ), ARGUMENTS_T... arguments )
+		{
+			ThreadAttributes attributes;
+			attributes.launchMode = POOLED_THREAD;
+			attributes.treeBehavior = CONCURRENT_TREE;
+			return FutureOf< RETURN_TYPE_T >( Implementation::Launch( attributes, managmentBehavior, 
+					LibThreadIt::MakeAtomicResource(), nullptr, DETACH, 
+					CallItLater::MakeAppliedProcedure< RETURN_TYPE_T, ARGUMENTS_T... >( functionToRun, arguments... ) ) );
+		}
+		template< typename CLASS_T, typename RETURN_TYPE_T, typename... ARGUMENTS_T >
+		Future< RETURN_TYPE_T > MethodThreadItFuture( THREAD_ATOMIC_MANAGMENT managmentBehavior, 
+				CLASS_T* classInstance, RETURN_TYPE_T(CLASS_T::* methodToRun )( ARGUMENTS_T... ), 
+				ARGUMENTS_T... arguments )
+		{
+			ThreadAttributes attributes;
+			attributes.launchMode = POOLED_THREAD;
+			attributes.treeBehavior = CONCURRENT_TREE;
+			return FutureOf< RETURN_TYPE_T >( Implementation::Launch( attributes, managmentBehavior, 
+					LibThreadIt::MakeAtomicResource(), nullptr, DETACH, 
+					CallItLater::MakeAppliedMethod< CLASS_T, RETURN_TYPE_T, ARGUMENTS_T... >( 
+					classInstance, methodToRun, arguments... ) ) );
+		}
+	#endif
+	/*Blocks until every handle has finished. The caller sleeps in the kernel once and 
+	is woken by the last handle to complete, rather than joining each in turn. Handles 
+	launched with JOIN still have to be joined, that no longer waits though.*/
+	void WaitAll( const std::vector< std::shared_ptr< LibThreadIt::ThreadHandle > >& handles );
+	//False if "timeout" passed before every handle finished.//
+	bool WaitAllFor( const std::vector< std::shared_ptr< LibThreadIt::ThreadHandle > >& handles, 
+			std::chrono::nanoseconds timeout );
+	/*The index of a handle that has finished, waiting for the first one to if none 
+	has yet. "handles.size()" if there are no handles.*/
+	std::size_t WaitAny( const std::vector< std::shared_ptr< LibThreadIt::ThreadHandle > >& handles );
+	//As WaitAny, "handles.size()" if "timeout" passed first.//
+	std::size_t WaitAnyFor( const std::vector< std::shared_ptr< LibThreadIt::ThreadHandle > >& handles, 
+			std::chrono::nanoseconds timeout );
 	template< typename ATOMIC_TYPE_T >
 	LibThreadIt::Atomic< ATOMIC_TYPE_T > MakeAtomic( std::shared_ptr< LibThreadIt::ThreadHandle > handle, ATOMIC_TYPE_T* data ) {
 		LibThreadIt::Atomic< ATOMIC_TYPE_T > atomic( handle->Branch( data ) );
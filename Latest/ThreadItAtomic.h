@@ -11,10 +11,18 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, 
 WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 */
+#pragma once
 #include <iostream>
 #include <CallItLater.h>
-#define THREAD_IT_NACL_PLATFORM
-//#define THREAD_IT_NACL_PLATFORM_DEBUG
+/*Pick a back end unless the user already chose one, Google Native Client 
+builds get the NaCl back end, everything else is treated as POSIX.*/
+#if !defined( THREAD_IT_NACL_PLATFORM ) && !defined( THREAD_IT_POSIX_PLATFORM )
+	#ifdef __native_client__
+		#define THREAD_IT_NACL_PLATFORM
+	#else
+		#define THREAD_IT_POSIX_PLATFORM
+	#endif
+#endif
 #define THREAD_IT_HAS_CPP_STANDARD_ATOMIC
 #ifdef THREAD_IT_NACL_PLATFORM
 	#define _GLIBCXX_HAS_GTHREADS
@@ -26,20 +34,26 @@ WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
 	#include <vector>
 	#include <string>
 	#include <typeinfo>
+	#include <typeindex>
 	#include <utility>
 	#include <memory>
 #endif
-#ifdef THREAD_IT_NACL_PLATFORM_DEBUG
-	#include <ppapi/c/ppb_instance.h>
-	#include <ppapi/c/pp_module.h>
-	#include <ppapi/c/pp_var.h>
-	#include <ppapi/c/ppb.h>
-	#include <ppapi/c/ppb_input_event.h>
-	#include <ppapi/cpp/instance.h>
-	#include <ppapi/cpp/instance_handle.h>
-	#include <ppapi/cpp/module.h>
-	#include <ppapi/cpp/var.h>
-	#include <ppapi/cpp/completion_callback.h>
+#ifdef THREAD_IT_POSIX_PLATFORM
+	#include <pthread.h>
+	#include <sched.h>
+	#include <functional>
+	#include <atomic>
+	#include <mutex>
+	#include <condition_variable>
+	#include <thread>
+	#include <deque>
+	#include <iostream>
+	#include <vector>
+	#include <string>
+	#include <typeinfo>
+	#include <typeindex>
+	#include <utility>
+	#include <memory>
 #endif
 #ifdef THREAD_IT_HAS_CPP_STANDARD_ATOMIC
 	#ifdef THREAD_IT_NACL_PLATFORM
@@ -50,52 +64,213 @@ WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
 #endif
 #define THREAD_IT_EASY_THREAD
 #include <utility>
+#include <type_traits>
 #include <algorithm>
 #include <sstream>
+#include <AdaptiveLock.h>
+#include <LockTable.h>
+#include <ContentionProfiler.h>
+#include <RecyclingAllocator.h>
 namespace LibThreadIt
 {
+	#if defined( THREAD_IT_POSIX_PLATFORM ) && defined( __cpp_impl_coroutine )
+		namespace Implementation
+		{
+			template< typename ATOMIC_TYPE_T, bool IS_SHARED_T = false >
+			struct AtomicAwaiter;
+		}
+	#endif
+	enum ATOMIC_ACCESS {
+		//Exclusive, the default.//
+		WRITE_ACCESS = 0, 
+		//Shared with any other readers.//
+		READ_ACCESS = 1
+	};
 	struct BaseAtomic
 	{
-		std::string id;
-		#ifdef THREAD_IT_NACL_PLATFORM_DEBUG
-			std::string name;
-			pp::Instance* debugger;
-		#endif
+		//The type of the protected data, "ATOMIC_TYPE_T*."//
+		std::type_index id;
+		//Does this instance currently hold the lock, exclusively or shared?//
+		bool didWrite;
+		bool didRead;
+		/*Held through a PoolHold on the AtomicManager it was branched from, so it 
+		neither locks nor unlocks.*/
+		bool isCovered;
+		//How AquireAll takes this atomic.//
+		ATOMIC_ACCESS accessMode;
+		//When this instance's hold began, 0 if the profiler was off.//
+		std::uint64_t aquiredAt;
+		explicit BaseAtomic( std::type_index id_ ) : id( id_ ), didWrite( false ), didRead( false ), 
+				isCovered( false ), accessMode( WRITE_ACCESS ), aquiredAt( 0 ) {
+		}
 		#ifdef THREAD_IT_HAS_CPP_STANDARD_ATOMIC
-			std::shared_ptr< std::atomic< bool > > isBusy;
+			/*The lock word last used for the protected object, null if none was yet. It 
+			lives in the LockTable and is never freed, copies share the pointer.*/
+			AdaptiveLock* isBusy;
 		#endif
 		//So the resources can be aquired without needing to know the type.//
 		virtual bool AtomicAquire() = 0;
+		//'true' if this instance holds the lock afterwards, never waits.//
+		virtual bool TryAtomicAquire() = 0;
+		virtual bool AtomicAquireShared() = 0;
+		virtual bool TryAtomicAquireShared() = 0;
 		virtual bool Release() = 0;
+		//Aquire the way "accessMode" asks for.//
+		bool AquireForAccess()
+		{
+			if( accessMode == READ_ACCESS )
+				return AtomicAquireShared();
+			return AtomicAquire();
+		}
+		bool TryAquireForAccess()
+		{
+			if( accessMode == READ_ACCESS )
+				return TryAtomicAquireShared();
+			return TryAtomicAquire();
+		}
+		bool IsHeld() {
+			return ( didWrite == true || didRead == true || isCovered == true );
+		}
+		virtual const void* GetAddress() = 0;
+		//The type the lock word is looked up by, the protected type without const or volatile.//
+		virtual const std::type_info& GetLockType() = 0;
+		#ifdef THREAD_IT_HAS_CPP_STANDARD_ATOMIC
+			//Pools aquire in the order of these keys, so they can not deadlock each other.//
+			Implementation::LockKey GetLockKey()
+			{
+				const Implementation::LockKey KEY = { GetAddress(), &GetLockType() };
+				return KEY;
+			}
+			Implementation::LockControlBlock* GetLockBlock() {
+				return ( isBusy == nullptr ) ? nullptr : Implementation::LockControlBlock::Of( isBusy );
+			}
+			//Waits for the lock word, counting the aquire when the ContentionProfiler is on.//
+			void LockWord( ATOMIC_ACCESS access )
+			{
+				const bool IS_SHARED = ( access == READ_ACCESS );
+				aquiredAt = 0;
+				if( ContentionProfiler::IsEnabled() == false ) {
+					isBusy = &Implementation::LockTable::Lock( GetLockBlock(), GetLockKey(), IS_SHARED )->lock;
+					return;
+				}
+				std::uint64_t start = Implementation::ProfilerClock();
+				Implementation::LockControlBlock* block = Implementation::LockTable::TryLock( GetLockBlock(), GetLockKey(), IS_SHARED );
+				bool contended = ( block == nullptr );
+				if( contended == true )
+					block = Implementation::LockTable::Lock( GetLockBlock(), GetLockKey(), IS_SHARED );
+				isBusy = &block->lock;
+				aquiredAt = Implementation::ProfilerClock();
+				Implementation::RecordAquire( GetAddress(), id.name(), contended, aquiredAt - start );
+			}
+			bool TryLockWord( ATOMIC_ACCESS access )
+			{
+				Implementation::LockControlBlock* block = Implementation::LockTable::TryLock( 
+						GetLockBlock(), GetLockKey(), access == READ_ACCESS );
+				if( block == nullptr )
+					return ( false );
+				isBusy = &block->lock;
+				aquiredAt = 0;
+				if( ContentionProfiler::IsEnabled() == true ) {
+					aquiredAt = Implementation::ProfilerClock();
+					Implementation::RecordAquire( GetAddress(), id.name(), false, 0 );
+				}
+				return ( true );
+			}
+			//Call before unlocking.//
+			void ProfileRelease()
+			{
+				if( aquiredAt == 0 )
+					return;
+				Implementation::RecordRelease( GetAddress(), id.name(), Implementation::ProfilerClock() - aquiredAt );
+				aquiredAt = 0;
+			}
+		#endif
 	};
+	/*The lock word is found through the LockTable, which never frees one, so a copy 
+	may outlive the Atomic or pool it came from and copying costs no more than the 
+	members.*/
 	template< typename ATOMIC_TYPE_T >
 	struct Atomic : public BaseAtomic
 	{
 		ATOMIC_TYPE_T* atomicData;
-		bool didWrite;
-		#ifdef THREAD_IT_NACL_PLATFORM_DEBUG
-			void Debug( std::string message )
-			{
-				std::stringstream messageBuffer;
-				messageBuffer << "From atomic " << name << " with isBusy at " << isBusy->load( std::memory_order_acquire ) << 
-						" with address " << isBusy.get() << " and didWrite at " << didWrite << ": " << message;
-				debugger->PostMessage( messageBuffer.str() );
-			}
-		#endif
-		explicit Atomic()
+		//The lock word is looked up on first aquire.//
+		explicit Atomic() : BaseAtomic( typeid( ATOMIC_TYPE_T* ) )
 		{
 			didWrite = false;
-			id = typeid( ATOMIC_TYPE_T* ).name();
 			#ifdef THREAD_IT_HAS_CPP_STANDARD_ATOMIC
-				isBusy = std::make_shared< std::atomic< bool > >( false );
+				isBusy = nullptr;
+			#endif
+		}
+		explicit Atomic( ATOMIC_TYPE_T* atomicData_ ) : BaseAtomic( typeid( ATOMIC_TYPE_T* ) ), 
+				atomicData( atomicData_ )
+		{
+			didWrite = false;
+			#ifdef THREAD_IT_HAS_CPP_STANDARD_ATOMIC
+				isBusy = nullptr;
+			#endif
+		}
+		Atomic( const Atomic< ATOMIC_TYPE_T >& other ) : BaseAtomic( other.id )
+		{
+			didWrite = other.didWrite;
+			didRead = other.didRead;
+			isCovered = other.isCovered;
+			accessMode = other.accessMode;
+			aquiredAt = other.aquiredAt;
+			atomicData = other.atomicData;
+			#ifdef THREAD_IT_HAS_CPP_STANDARD_ATOMIC
+				isBusy = other.isBusy;
+			#endif
+		}
+		//"noexcept" so a vector that grows moves its Atomics, holds and all, rather than copying them.//
+		Atomic( Atomic< ATOMIC_TYPE_T >&& other ) noexcept : BaseAtomic( other.id )
+		{
+			didWrite = other.didWrite;
+			didRead = other.didRead;
+			isCovered = other.isCovered;
+			accessMode = other.accessMode;
+			aquiredAt = other.aquiredAt;
+			atomicData = other.atomicData;
+			#ifdef THREAD_IT_HAS_CPP_STANDARD_ATOMIC
+				isBusy = other.isBusy;
+			#endif
+			//The hold moved with it.//
+			other.didWrite = false;
+			other.didRead = false;
+		}
+		//Lets go of whatever this instance held, then takes on "other" as the copy constructor does.//
+		Atomic< ATOMIC_TYPE_T >& operator=( const Atomic< ATOMIC_TYPE_T >& other )
+		{
+			if( this == &other )
+				return *this;
+			Release();
+			didWrite = other.didWrite;
+			didRead = other.didRead;
+			isCovered = other.isCovered;
+			accessMode = other.accessMode;
+			aquiredAt = other.aquiredAt;
+			atomicData = other.atomicData;
+			#ifdef THREAD_IT_HAS_CPP_STANDARD_ATOMIC
+				isBusy = other.isBusy;
 			#endif
+			return *this;
 		}
-		Atomic( const Atomic< ATOMIC_TYPE_T >& other )
+		Atomic< ATOMIC_TYPE_T >& operator=( Atomic< ATOMIC_TYPE_T >&& other )
 		{
+			if( this == &other )
+				return *this;
+			Release();
 			didWrite = other.didWrite;
-			id = other.id;
-			isBusy = other.isBusy;
+			didRead = other.didRead;
+			isCovered = other.isCovered;
+			accessMode = other.accessMode;
+			aquiredAt = other.aquiredAt;
 			atomicData = other.atomicData;
+			#ifdef THREAD_IT_HAS_CPP_STANDARD_ATOMIC
+				isBusy = other.isBusy;
+			#endif
+			other.didWrite = false;
+			other.didRead = false;
+			return *this;
 		}
 		~Atomic() {
 			Release();
@@ -109,57 +284,109 @@ namespace LibThreadIt
 			in some thread along the line. Unlikly, but 
 			why not be sure.*/
 			bool status = true;
-			bool expected = false;
-			#ifdef THREAD_IT_NACL_PLATFORM_DEBUG
-				Debug( "waiting" );
-			#endif
+			if( isCovered == true )
+				return ( false );
+			//Readers can not upgrade in place, two of them trying would wait on each other.//
+			if( didRead == true )
+				Release();
 			if( didWrite == false )
 			{
-				#ifdef THREAD_IT_NACL_PLATFORM_DEBUG
-					Debug( "needed to wait" );
-				#endif
 				#ifdef THREAD_IT_HAS_CPP_STANDARD_ATOMIC
-					while( ( !isBusy->compare_exchange_weak( expected, true, 
-							std::memory_order_release, std::memory_order_acquire ) ) )
-						expected = false;
+					LockWord( WRITE_ACCESS );
 				#endif
 			}
 			else
 				status = false;
 			didWrite = true;
-			#ifdef THREAD_IT_NACL_PLATFORM_DEBUG
-				Debug( "finished waiting" );
-			#endif
 			return status;
 		}
+		virtual bool TryAtomicAquire()
+		{
+			if( didWrite == true || isCovered == true )
+				return ( true );
+			if( didRead == true )
+				return ( false );
+			#ifdef THREAD_IT_HAS_CPP_STANDARD_ATOMIC
+				if( TryLockWord( WRITE_ACCESS ) == false )
+					return ( false );
+			#endif
+			didWrite = true;
+			return ( true );
+		}
+		//Holding it exclusively already counts as being able to read.//
+		virtual bool AtomicAquireShared()
+		{
+			if( IsHeld() == true )
+				return ( false );
+			#ifdef THREAD_IT_HAS_CPP_STANDARD_ATOMIC
+				LockWord( READ_ACCESS );
+			#endif
+			didRead = true;
+			return ( true );
+		}
+		virtual bool TryAtomicAquireShared()
+		{
+			if( IsHeld() == true )
+				return ( true );
+			#ifdef THREAD_IT_HAS_CPP_STANDARD_ATOMIC
+				if( TryLockWord( READ_ACCESS ) == false )
+					return ( false );
+			#endif
+			didRead = true;
+			return ( true );
+		}
 		ATOMIC_TYPE_T* Aquire() {
 			AtomicAquire();
 			return atomicData;
 		}
+		#if defined( THREAD_IT_POSIX_PLATFORM ) && defined( __cpp_impl_coroutine )
+			/*"co_await atomic.AquireAsync()" suspends the coroutine rather than the thread 
+			until the lock is ours, then gives the data like Aquire. See Coroutine.h.*/
+			Implementation::AtomicAwaiter< ATOMIC_TYPE_T > AquireAsync() {
+				return Implementation::AtomicAwaiter< ATOMIC_TYPE_T >( this );
+			}
+			//"co_await atomic.ReadAsync()" is to Read what AquireAsync is to Aquire.//
+			Implementation::AtomicAwaiter< ATOMIC_TYPE_T, true > ReadAsync() {
+				return Implementation::AtomicAwaiter< ATOMIC_TYPE_T, true >( this );
+			}
+		#endif
+		//Read only access, shared with other readers, released like any other aquire.//
+		const ATOMIC_TYPE_T* Read() {
+			AtomicAquireShared();
+			return atomicData;
+		}
+		virtual const void* GetAddress() {
+			return atomicData;
+		}
+		virtual const std::type_info& GetLockType() {
+			return typeid( typename std::remove_cv< ATOMIC_TYPE_T >::type );
+		}
 		virtual bool Release()
 		{
-			#ifdef THREAD_IT_NACL_PLATFORM_DEBUG
-				Debug( "releasing" );
-			#endif
 			/*In case the data got corrupted somewhere 
 			in some thread along the line. Unlikly, but 
 			why not be sure.*/
 			bool status = true;
+			if( isCovered == true )
+				return ( false );
 			if( didWrite == true )
 			{
-				#ifdef THREAD_IT_NACL_PLATFORM_DEBUG
-					Debug( "needed to release" );
+				#ifdef THREAD_IT_HAS_CPP_STANDARD_ATOMIC
+					ProfileRelease();
+					Implementation::LockTable::Unlock( GetLockBlock(), false );
 				#endif
+			}
+			else if( didRead == true )
+			{
 				#ifdef THREAD_IT_HAS_CPP_STANDARD_ATOMIC
-					isBusy->store( false, std::memory_order_release );
+					ProfileRelease();
+					Implementation::LockTable::Unlock( GetLockBlock(), true );
 				#endif
 			}
 			else
 				status = false;
 			didWrite = false;
-			#ifdef THREAD_IT_NACL_PLATFORM_DEBUG
-				Debug( "released" );
-			#endif
+			didRead = false;
 			return status;
 		}
 	};
@@ -0,0 +1,306 @@
+/*
+Copyright (C) 2013 Christopher A. Greeley
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), 
+to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, 
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+#include <Timer.h>
+
+namespace LibThreadIt
+{
+	namespace Implementation
+	{
+		#ifdef THREAD_IT_POSIX_PLATFORM
+			namespace
+			{
+				const std::uint64_t NO_EVENT = UINT64_MAX;
+				//The first tick in a slot of "level" is a multiple of 1 << ShiftOf( level ).//
+				unsigned int ShiftOf( int level ) {
+					return ( level * TimerWheel::SLOT_BITS );
+				}
+				std::uint64_t MaskOf( int level ) {
+					return ( ( std::uint64_t( 1 ) << ShiftOf( level ) ) - 1 );
+				}
+			}
+			void TimerNode::RunOnWorker()
+			{
+				TimerWheel* owner = wheel;
+				if( isCancelled.load( std::memory_order_acquire ) == false )
+					callback();
+				if( period != 0 ) {
+					//Either back on the wheel or gone, "this" is not ours after this call.//
+					owner->Reschedule( this );
+					return;
+				}
+				std::shared_ptr< TimerNode > last;
+				last.swap( self );
+				owner->Finished();
+			}
+			TimerWheel::TimerWheel() : start( std::chrono::steady_clock::now() ), currentTick( 0 ), 
+					sleepingUntil( 0 ), overflow( nullptr ), amountPending( 0 ), amountRunning( 0 ), 
+					isStopping( false )
+			{
+				//Made first so it is destroyed after us, our timers run on it.//
+				WorkerPool::Global();
+				for( unsigned int level = 0; level < AMOUNT_OF_LEVELS; ++level )
+				{
+					occupied[ level ] = 0;
+					for( unsigned int slot = 0; slot < SLOTS_PER_LEVEL; ++slot )
+						slots[ level ][ slot ] = nullptr;
+				}
+				service = std::thread( &TimerWheel::Serve, this );
+			}
+			TimerWheel::~TimerWheel()
+			{
+				{
+					std::lock_guard< std::mutex > lock( guard );
+					isStopping = true;
+				}
+				changed.notify_all();
+				service.join();
+				//A timer on the pool still comes back to us once its callback returns.//
+				while( amountRunning.load( std::memory_order_acquire ) != 0 )
+					std::this_thread::yield();
+				//What is left never fires.//
+				for( int level = 0; level <= OVERFLOW_LEVEL; ++level )
+				{
+					const unsigned int AMOUNT_OF_SLOTS = ( level == OVERFLOW_LEVEL ) ? 1 : SLOTS_PER_LEVEL;
+					for( unsigned int slot = 0; slot < AMOUNT_OF_SLOTS; ++slot )
+					{
+						TimerNode* node = ( level == OVERFLOW_LEVEL ) ? overflow : slots[ level ][ slot ];
+						while( node != nullptr ) {
+							TimerNode* next = node->next;
+							node->level = TimerNode::NOT_LINKED;
+							node->self.reset();
+							node = next;
+						}
+					}
+				}
+			}
+			void TimerWheel::Schedule( std::shared_ptr< TimerNode > node, std::chrono::nanoseconds delay )
+			{
+				std::vector< PoolTask* > due;
+				node->wheel = this;
+				node->self = node;
+				{
+					std::lock_guard< std::mutex > lock( guard );
+					const std::uint64_t NOW = NowTick();
+					//Nothing is linked relative to the old tick, catch up without walking the gap.//
+					if( amountPending == 0 && currentTick < NOW )
+						currentTick = NOW;
+					//Rounding the due time up, not just the delay, keeps it from firing early.//
+					node->expiry = ( delay.count() <= 0 ) ? NOW : TicksOf( std::chrono::duration_cast< 
+							std::chrono::nanoseconds >( std::chrono::steady_clock::now() - start ) + delay );
+					Link( node.get(), due );
+					if( node->expiry < sleepingUntil )
+						changed.notify_one();
+				}
+				Dispatch( due );
+			}
+			bool TimerWheel::Cancel( TimerNode* node )
+			{
+				//Declared before the lock so the timer is let go of after the lock is.//
+				std::shared_ptr< TimerNode > dropped;
+				std::lock_guard< std::mutex > lock( guard );
+				if( node->isCancelled.load( std::memory_order_relaxed ) == true )
+					return ( false );
+				node->isCancelled.store( true, std::memory_order_release );
+				//Already on the pool, it lets itself go once it sees the flag.//
+				if( node->level == TimerNode::NOT_LINKED )
+					return ( false );
+				Unlink( node );
+				dropped.swap( node->self );
+				return ( true );
+			}
+			void TimerWheel::Reschedule( TimerNode* node )
+			{
+				std::shared_ptr< TimerNode > dropped;
+				std::vector< PoolTask* > due;
+				{
+					std::lock_guard< std::mutex > lock( guard );
+					if( isStopping == true || node->isCancelled.load( std::memory_order_relaxed ) == true )
+						dropped.swap( node->self );
+					else
+					{
+						const std::uint64_t NOW = NowTick();
+						if( amountPending == 0 && currentTick < NOW )
+							currentTick = NOW;
+						node->expiry += node->period;
+						//Skip the periods the callback overran.//
+						if( node->expiry <= NOW )
+							node->expiry += ( ( NOW - node->expiry ) / node->period + 1 ) * node->period;
+						Link( node, due );
+						if( node->expiry < sleepingUntil )
+							changed.notify_one();
+					}
+				}
+				Dispatch( due );
+				Finished();
+			}
+			void TimerWheel::Finished() {
+				amountRunning.fetch_sub( 1, std::memory_order_release );
+			}
+			bool TimerWheel::IsPending( TimerNode* node )
+			{
+				std::lock_guard< std::mutex > lock( guard );
+				return ( node->isCancelled.load( std::memory_order_relaxed ) == false && 
+						( node->level != TimerNode::NOT_LINKED || node->period != 0 ) );
+			}
+			std::size_t TimerWheel::GetAmountPending()
+			{
+				std::lock_guard< std::mutex > lock( guard );
+				return amountPending;
+			}
+			std::uint64_t TimerWheel::TicksOf( std::chrono::nanoseconds duration )
+			{
+				if( duration.count() <= 0 )
+					return ( 0 );
+				return ( ( duration.count() + 999999 ) / 1000000 );
+			}
+			TimerWheel& TimerWheel::Global()
+			{
+				static TimerWheel global;
+				return global;
+			}
+			std::uint64_t TimerWheel::NowTick() {
+				return ( std::chrono::duration_cast< std::chrono::milliseconds >( 
+						std::chrono::steady_clock::now() - start ).count() );
+			}
+			void TimerWheel::Link( TimerNode* node, std::vector< PoolTask* >& due )
+			{
+				if( node->expiry <= currentTick ) {
+					node->level = TimerNode::NOT_LINKED;
+					due.push_back( node );
+					return;
+				}
+				/*The finest level whose slot is in the current turn of the next level up, 
+				so a timer is always in a slot past the wheel's position on its level.*/
+				int level = 0;
+				while( level < OVERFLOW_LEVEL && ( node->expiry >> ShiftOf( level + 1 ) ) != 
+						( currentTick >> ShiftOf( level + 1 ) ) )
+					++level;
+				TimerNode** head = &overflow;
+				node->slot = 0;
+				if( level != OVERFLOW_LEVEL ) {
+					node->slot = ( node->expiry >> ShiftOf( level ) ) & ( SLOTS_PER_LEVEL - 1 );
+					head = &slots[ level ][ node->slot ];
+					occupied[ level ] |= std::uint64_t( 1 ) << node->slot;
+				}
+				node->level = level;
+				node->previous = nullptr;
+				node->next = *head;
+				if( *head != nullptr )
+					( *head )->previous = node;
+				*head = node;
+				++amountPending;
+			}
+			void TimerWheel::Unlink( TimerNode* node )
+			{
+				TimerNode** head = ( node->level == OVERFLOW_LEVEL ) ? &overflow : &slots[ node->level ][ node->slot ];
+				if( node->previous != nullptr )
+					node->previous->next = node->next;
+				else
+					*head = node->next;
+				if( node->next != nullptr )
+					node->next->previous = node->previous;
+				if( node->level != OVERFLOW_LEVEL && *head == nullptr )
+					occupied[ node->level ] &= ~( std::uint64_t( 1 ) << node->slot );
+				node->level = TimerNode::NOT_LINKED;
+				node->next = nullptr;
+				node->previous = nullptr;
+				--amountPending;
+			}
+			void TimerWheel::Cascade( int level, unsigned int slot, std::vector< PoolTask* >& due )
+			{
+				TimerNode** head = ( level == OVERFLOW_LEVEL ) ? &overflow : &slots[ level ][ slot ];
+				TimerNode* node = *head;
+				*head = nullptr;
+				if( level != OVERFLOW_LEVEL )
+					occupied[ level ] &= ~( std::uint64_t( 1 ) << slot );
+				while( node != nullptr ) {
+					TimerNode* next = node->next;
+					--amountPending;
+					Link( node, due );
+					node = next;
+				}
+			}
+			void TimerWheel::Advance( std::uint64_t tick, std::vector< PoolTask* >& due )
+			{
+				while( currentTick < tick )
+				{
+					//Jump straight to the next tick something happens at.//
+					const std::uint64_t NEXT_EVENT = NextEventTick();
+					if( NEXT_EVENT > tick ) {
+						currentTick = tick;
+						return;
+					}
+					currentTick = NEXT_EVENT;
+					//Coarsest first, so what comes down a level can come down further.//
+					if( ( currentTick & MaskOf( OVERFLOW_LEVEL ) ) == 0 )
+						Cascade( OVERFLOW_LEVEL, 0, due );
+					for( int level = AMOUNT_OF_LEVELS - 1; level > 0; --level )
+						if( ( currentTick & MaskOf( level ) ) == 0 )
+							Cascade( level, ( currentTick >> ShiftOf( level ) ) & ( SLOTS_PER_LEVEL - 1 ), due );
+					//Everything in the finest slot is due now.//
+					Cascade( 0, currentTick & ( SLOTS_PER_LEVEL - 1 ), due );
+				}
+			}
+			std::uint64_t TimerWheel::NextEventTick()
+			{
+				std::uint64_t nextEvent = NO_EVENT;
+				for( unsigned int level = 0; level < AMOUNT_OF_LEVELS; ++level )
+				{
+					const unsigned int POSITION = ( currentTick >> ShiftOf( level ) ) & ( SLOTS_PER_LEVEL - 1 );
+					//Only slots past the wheel's position are in use, see Link().//
+					const std::uint64_t AHEAD = ( POSITION == SLOTS_PER_LEVEL - 1 ) ? 0 : 
+							( occupied[ level ] & ( ~std::uint64_t( 0 ) << ( POSITION + 1 ) ) );
+					if( AHEAD == 0 )
+						continue;
+					const std::uint64_t SLOT_START = ( currentTick & ~MaskOf( level + 1 ) ) | 
+							( std::uint64_t( __builtin_ctzll( AHEAD ) ) << ShiftOf( level ) );
+					nextEvent = std::min( nextEvent, SLOT_START );
+				}
+				if( overflow != nullptr )
+					nextEvent = std::min( nextEvent, ( currentTick | MaskOf( OVERFLOW_LEVEL ) ) + 1 );
+				return nextEvent;
+			}
+			void TimerWheel::Dispatch( std::vector< PoolTask* >& due )
+			{
+				if( due.empty() == true )
+					return;
+				amountRunning.fetch_add( due.size(), std::memory_order_relaxed );
+				WorkerPool::Global().SubmitBatch( due.data(), due.size() );
+			}
+			void TimerWheel::Serve()
+			{
+				std::vector< PoolTask* > due;
+				std::unique_lock< std::mutex > lock( guard );
+				while( isStopping == false )
+				{
+					Advance( NowTick(), due );
+					if( due.empty() == false ) {
+						lock.unlock();
+						Dispatch( due );
+						due.clear();
+						lock.lock();
+						continue;
+					}
+					sleepingUntil = NextEventTick();
+					if( sleepingUntil == NO_EVENT )
+						changed.wait( lock );
+					else
+						changed.wait_until( lock, start + std::chrono::milliseconds( sleepingUntil ) );
+					//Awake, a new timer does not need to wake us.//
+					sleepingUntil = 0;
+				}
+			}
+		#endif
+	}
+}
@@ -0,0 +1,158 @@
+/*
+Copyright (C) 2013 Christopher A. Greeley
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), 
+to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, 
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+#pragma once
+#include <chrono>
+#include <ThreadItAtomic.h>
+#include <WorkerPool.h>
+
+namespace LibThreadIt
+{
+	#ifdef THREAD_IT_POSIX_PLATFORM
+		namespace Implementation
+		{
+			class TimerWheel;
+			//A pending timer, it keeps itself alive while it is on the wheel or on the pool.//
+			struct TimerNode : public PoolTask
+			{
+				std::function< void() > callback;
+				TimerWheel* wheel;
+				//In ticks of the wheel.//
+				std::uint64_t expiry;
+				//0 for a one shot timer.//
+				std::uint64_t period;
+				//Where it is linked, NOT_LINKED while it is running or done.//
+				int level;
+				unsigned int slot;
+				TimerNode* next;
+				TimerNode* previous;
+				//Only set while holding the wheel's guard, read without it.//
+				std::atomic< bool > isCancelled;
+				std::shared_ptr< TimerNode > self;
+				explicit TimerNode() : wheel( nullptr ), expiry( 0 ), period( 0 ), level( NOT_LINKED ), 
+						slot( 0 ), next( nullptr ), previous( nullptr ), isCancelled( false ) {
+				}
+				static const int NOT_LINKED = -1;
+				virtual void RunOnWorker();
+			};
+			/*A hierarchical timing wheel, after Varghese and Lauck. Four levels of 64 slots, 
+			the first a millisecond per slot and each level 64 times coarser, so timers up 
+			to about 4.6 hours away are linked in O( 1 ) and the rest wait on an overflow 
+			list. Timers in a coarser slot are moved down a level when the wheel reaches 
+			that slot. One service thread sleeps until the next occupied slot, found from a 
+			bitmap per level, and hands timers that are due to the worker pool.*/
+			class TimerWheel
+			{
+				public: 
+					static const unsigned int SLOT_BITS = 6;
+					static const unsigned int SLOTS_PER_LEVEL = 1 << SLOT_BITS;
+					static const unsigned int AMOUNT_OF_LEVELS = 4;
+					static const int OVERFLOW_LEVEL = AMOUNT_OF_LEVELS;
+					explicit TimerWheel();
+					~TimerWheel();
+					//"delay" is rounded up to whole ticks, a timer never fires early.//
+					void Schedule( std::shared_ptr< TimerNode > node, std::chrono::nanoseconds delay );
+					//'true' if the timer had not been handed to the pool yet.//
+					bool Cancel( TimerNode* node );
+					//Called by a periodic timer once its callback returns.//
+					void Reschedule( TimerNode* node );
+					//Called by a timer once it is done with the wheel.//
+					void Finished();
+					bool IsPending( TimerNode* node );
+					std::size_t GetAmountPending();
+					//Whole ticks, rounded up.//
+					static std::uint64_t TicksOf( std::chrono::nanoseconds duration );
+					static TimerWheel& Global();
+				protected: 
+					std::uint64_t NowTick();
+					void Link( TimerNode* node, std::vector< PoolTask* >& due );
+					void Unlink( TimerNode* node );
+					//Takes every timer from a slot to be linked again further down.//
+					void Cascade( int level, unsigned int slot, std::vector< PoolTask* >& due );
+					//Moves "currentTick" up to "tick, " collecting what is due.//
+					void Advance( std::uint64_t tick, std::vector< PoolTask* >& due );
+					//The next tick anything has to happen at, UINT64_MAX if the wheel is empty.//
+					std::uint64_t NextEventTick();
+					void Dispatch( std::vector< PoolTask* >& due );
+					void Serve();
+					std::chrono::steady_clock::time_point start;
+					std::mutex guard;
+					std::condition_variable changed;
+					std::uint64_t currentTick;
+					std::uint64_t sleepingUntil;
+					TimerNode* slots[ AMOUNT_OF_LEVELS ][ SLOTS_PER_LEVEL ];
+					std::uint64_t occupied[ AMOUNT_OF_LEVELS ];
+					TimerNode* overflow;
+					std::size_t amountPending;
+					//Timers on the pool, the wheel has to outlive them.//
+					std::atomic< std::size_t > amountRunning;
+					bool isStopping;
+					std::thread service;
+			};
+		}
+		/*What ThreadItAfter and ThreadItEvery give back. Dropping it does not cancel 
+		the timer.*/
+		class TimerHandle
+		{
+			std::shared_ptr< Implementation::TimerNode > node;
+			public: 
+				explicit TimerHandle() {
+				}
+				explicit TimerHandle( std::shared_ptr< Implementation::TimerNode > node_ ) : node( node_ ) {
+				}
+				/*Stops the timer, a periodic one fires no more after this returns, bar a 
+				callback already running. 'true' if it was stopped before it was due.*/
+				bool Cancel()
+				{
+					if( node == nullptr )
+						return ( false );
+					return node->wheel->Cancel( node.get() );
+				}
+				//Not cancelled, and if it is one shot not handed to the pool yet.//
+				bool IsPending() {
+					return ( node != nullptr && node->wheel->IsPending( node.get() ) );
+				}
+		};
+		namespace Implementation
+		{
+			template< typename FUNCTION_T, typename... ARGUMENTS_T >
+			TimerHandle StartTimer( std::chrono::nanoseconds delay, std::chrono::nanoseconds period, 
+					FUNCTION_T&& function, ARGUMENTS_T&&... arguments )
+			{
+				std::shared_ptr< TimerNode > node = MakeRecycled< TimerNode >();
+				node->callback = std::bind( std::forward< FUNCTION_T >( function ), 
+						std::forward< ARGUMENTS_T >( arguments )... );
+				//A period shorter than a tick still fires once a tick.//
+				if( period.count() > 0 )
+					node->period = std::max< std::uint64_t >( TimerWheel::TicksOf( period ), 1 );
+				TimerWheel::Global().Schedule( node, delay );
+				return TimerHandle( node );
+			}
+		}
+		/*Runs "function( arguments... )" on the worker pool once "delay" has passed, 
+		without holding a thread meanwhile. The arguments are copied in.*/
+		template< typename FUNCTION_T, typename... ARGUMENTS_T >
+		TimerHandle ThreadItAfter( std::chrono::nanoseconds delay, FUNCTION_T&& function, ARGUMENTS_T&&... arguments ) {
+			return Implementation::StartTimer( delay, std::chrono::nanoseconds( 0 ), 
+					std::forward< FUNCTION_T >( function ), std::forward< ARGUMENTS_T >( arguments )... );
+		}
+		/*Runs "function( arguments... )" every "period" until cancelled, the first time 
+		one period from now. Periods missed while the callback ran long are skipped, 
+		not run back to back.*/
+		template< typename FUNCTION_T, typename... ARGUMENTS_T >
+		TimerHandle ThreadItEvery( std::chrono::nanoseconds period, FUNCTION_T&& function, ARGUMENTS_T&&... arguments ) {
+			return Implementation::StartTimer( period, period, 
+					std::forward< FUNCTION_T >( function ), std::forward< ARGUMENTS_T >( arguments )... );
+		}
+	#endif
+}
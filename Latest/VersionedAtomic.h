@@ -0,0 +1,110 @@
+/*
+Copyright (C) 2013 Christopher A. Greeley
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), 
+to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, 
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+#pragma once
+#include <ThreadItAtomic.h>
+#include <cstring>
+#include <type_traits>
+
+namespace LibThreadIt
+{
+	/*For small, trivially copyable data that is read far more than it is written. 
+	A seqlock: readers copy the value and check the version did not move while they 
+	did, so a read never writes shared memory and readers do not slow each other 
+	down. Writers take a lock among themselves and make the version odd while they 
+	write. The value is kept in relaxed atomic words so a read racing a write is a 
+	retry, not undefined behaviour.*/
+	template< typename VALUE_T >
+	class VersionedAtomic
+	{
+		static_assert( std::is_trivially_copyable< VALUE_T >::value, 
+				"VersionedAtomic copies its value a word at a time, it has to be trivially copyable." );
+		static const std::size_t AMOUNT_OF_WORDS = ( sizeof( VALUE_T ) + sizeof( std::uint64_t ) - 1 ) / sizeof( std::uint64_t );
+		std::atomic< std::uint32_t > version;
+		std::atomic< std::uint64_t > words[ AMOUNT_OF_WORDS ];
+		AdaptiveLock writeGuard;
+		void CopyOut( VALUE_T& value )
+		{
+			std::uint64_t copy[ AMOUNT_OF_WORDS ];
+			for( std::size_t i = 0; i < AMOUNT_OF_WORDS; ++i )
+				copy[ i ] = words[ i ].load( std::memory_order_relaxed );
+			std::memcpy( &value, copy, sizeof( VALUE_T ) );
+		}
+		void CopyIn( const VALUE_T& value )
+		{
+			std::uint64_t copy[ AMOUNT_OF_WORDS ] = {};
+			std::memcpy( copy, &value, sizeof( VALUE_T ) );
+			for( std::size_t i = 0; i < AMOUNT_OF_WORDS; ++i )
+				words[ i ].store( copy[ i ], std::memory_order_relaxed );
+		}
+		//Call with "writeGuard" held.//
+		void Write( const VALUE_T& value )
+		{
+			std::uint32_t current = version.load( std::memory_order_relaxed );
+			version.store( current + 1, std::memory_order_relaxed );
+			//Readers that see any of the new words see the odd version.//
+			std::atomic_thread_fence( std::memory_order_release );
+			CopyIn( value );
+			version.store( current + 2, std::memory_order_release );
+		}
+		public: 
+			explicit VersionedAtomic() : version( 0 ) {
+				CopyIn( VALUE_T() );
+			}
+			explicit VersionedAtomic( const VALUE_T& value ) : version( 0 ) {
+				CopyIn( value );
+			}
+			VersionedAtomic( const VersionedAtomic& other ) = delete;
+			VersionedAtomic& operator=( const VersionedAtomic& other ) = delete;
+			//One attempt, 'false' if a writer got in the way.//
+			bool TryLoad( VALUE_T& value )
+			{
+				std::uint32_t before = version.load( std::memory_order_acquire );
+				if( ( before & 1 ) != 0 )
+					return ( false );
+				CopyOut( value );
+				//Keeps the copy above from moving below the second read of the version.//
+				std::atomic_thread_fence( std::memory_order_acquire );
+				return ( version.load( std::memory_order_relaxed ) == before );
+			}
+			//Retries until it gets a copy no writer touched.//
+			VALUE_T Load()
+			{
+				VALUE_T value;
+				while( TryLoad( value ) == false )
+					Implementation::CpuRelax();
+				return value;
+			}
+			void Store( const VALUE_T& value )
+			{
+				writeGuard.Lock();
+				Write( value );
+				writeGuard.Unlock();
+			}
+			//Calls "modify( VALUE_T& )" on a copy of the current value and stores the result, writers in between wait.//
+			template< typename MODIFY_T >
+			void Update( MODIFY_T modify )
+			{
+				writeGuard.Lock();
+				VALUE_T value;
+				CopyOut( value );
+				modify( value );
+				Write( value );
+				writeGuard.Unlock();
+			}
+			//Even, and moves by two with every write.//
+			std::uint32_t GetVersion() {
+				return version.load( std::memory_order_acquire );
+			}
+	};
+}
@@ -0,0 +1,127 @@
+/*
+Copyright (C) 2013 Christopher A. Greeley
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), 
+to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, 
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+#pragma once
+#include <ThreadItAtomic.h>
+
+namespace LibThreadIt
+{
+	namespace Implementation
+	{
+		#ifdef THREAD_IT_HAS_CPP_STANDARD_ATOMIC
+			/*Chase - Lev deque: the owning thread pushes and pops at the bottom, any other 
+			thread may steal from the top. "ELEMENT_T" has to be trivially copyable, in 
+			practice it is always a pointer.*/
+			template< typename ELEMENT_T >
+			class WorkStealingDeque
+			{
+				struct Buffer
+				{
+					explicit Buffer( long capacity_ ) : capacity( capacity_ ), 
+							elements( new std::atomic< ELEMENT_T >[ capacity_ ] ) {
+					}
+					~Buffer() {
+						delete[] elements;
+					}
+					ELEMENT_T Get( long index ) {
+						return elements[ index & ( capacity - 1 ) ].load( std::memory_order_relaxed );
+					}
+					void Put( long index, ELEMENT_T element ) {
+						elements[ index & ( capacity - 1 ) ].store( element, std::memory_order_relaxed );
+					}
+					Buffer* Grow( long bottom, long top )
+					{
+						Buffer* grown = new Buffer( capacity * 2 );
+						for( long i = top; i < bottom; ++i )
+							grown->Put( i, Get( i ) );
+						return grown;
+					}
+					const long capacity;
+					std::atomic< ELEMENT_T >* elements;
+				};
+				public: 
+					explicit WorkStealingDeque( long capacity = 256 ) : top( 0 ), bottom( 0 ), 
+							buffer( new Buffer( capacity ) ) {
+					}
+					~WorkStealingDeque()
+					{
+						delete buffer.load( std::memory_order_relaxed );
+						const unsigned int AMOUNT_OF_RETIRED = retired.size();
+						for( unsigned int i = 0; i < AMOUNT_OF_RETIRED; ++i )
+							delete retired[ i ];
+					}
+					//Owner only.//
+					void Push( ELEMENT_T element )
+					{
+						long currentBottom = bottom.load( std::memory_order_relaxed );
+						long currentTop = top.load( std::memory_order_acquire );
+						Buffer* currentBuffer = buffer.load( std::memory_order_relaxed );
+						if( currentBottom - currentTop > currentBuffer->capacity - 1 )
+						{
+							/*Thieves may still be reading the old buffer, so it is kept 
+							until the deque goes away.*/
+							retired.push_back( currentBuffer );
+							currentBuffer = currentBuffer->Grow( currentBottom, currentTop );
+							buffer.store( currentBuffer, std::memory_order_release );
+						}
+						currentBuffer->Put( currentBottom, element );
+						std::atomic_thread_fence( std::memory_order_release );
+						bottom.store( currentBottom + 1, std::memory_order_relaxed );
+					}
+					//Owner only, newest first.//
+					bool Pop( ELEMENT_T& element )
+					{
+						long currentBottom = bottom.load( std::memory_order_relaxed ) - 1;
+						Buffer* currentBuffer = buffer.load( std::memory_order_relaxed );
+						bottom.store( currentBottom, std::memory_order_relaxed );
+						std::atomic_thread_fence( std::memory_order_seq_cst );
+						long currentTop = top.load( std::memory_order_relaxed );
+						if( currentTop > currentBottom ) {
+							bottom.store( currentBottom + 1, std::memory_order_relaxed );
+							return ( false );
+						}
+						element = currentBuffer->Get( currentBottom );
+						if( currentTop == currentBottom )
+						{
+							//Last element, race the thieves for it.//
+							bool won = top.compare_exchange_strong( currentTop, currentTop + 1, 
+									std::memory_order_seq_cst, std::memory_order_relaxed );
+							bottom.store( currentBottom + 1, std::memory_order_relaxed );
+							return won;
+						}
+						return ( true );
+					}
+					//Any thread, oldest first.//
+					bool Steal( ELEMENT_T& element )
+					{
+						long currentTop = top.load( std::memory_order_acquire );
+						std::atomic_thread_fence( std::memory_order_seq_cst );
+						long currentBottom = bottom.load( std::memory_order_acquire );
+						if( currentTop >= currentBottom )
+							return ( false );
+						element = buffer.load( std::memory_order_acquire )->Get( currentTop );
+						return top.compare_exchange_strong( currentTop, currentTop + 1, 
+								std::memory_order_seq_cst, std::memory_order_relaxed );
+					}
+					bool IsEmpty() {
+						return ( bottom.load( std::memory_order_acquire ) <= top.load( std::memory_order_acquire ) );
+					}
+				protected: 
+					std::atomic< long > top;
+					std::atomic< long > bottom;
+					std::atomic< Buffer* > buffer;
+					std::vector< Buffer* > retired;
+			};
+		#endif
+	}
+}
@@ -0,0 +1,408 @@
+/*
+Copyright (C) 2013 Christopher A. Greeley
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), 
+to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, 
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+#include <WorkerPool.h>
+#include <algorithm>
+
+namespace LibThreadIt
+{
+	namespace Implementation
+	{
+		#ifdef THREAD_IT_POSIX_PLATFORM
+			namespace
+			{
+				//Which pool, and which of its workers, the calling thread is.//
+				thread_local WorkerPool* currentPool = nullptr;
+				thread_local unsigned int currentWorker = 0;
+				//For picking victims, a cheap xorshift is plenty.//
+				thread_local unsigned int stealSeed = 2463534242u;
+				struct FunctionTask : public PoolTask
+				{
+					std::function< void() > function;
+					virtual void RunOnWorker() {
+						function();
+						delete this;
+					}
+				};
+				unsigned int NextVictim()
+				{
+					stealSeed ^= stealSeed << 13;
+					stealSeed ^= stealSeed >> 17;
+					stealSeed ^= stealSeed << 5;
+					return stealSeed;
+				}
+			}
+			WorkerPool::WorkerPool( unsigned int amountOfWorkers ) : 
+					topology( NumaTopology::Simulated( 1, ( amountOfWorkers == 0 ) ? 1 : amountOfWorkers ) ), 
+					pinsWorkers( false ), amountEverScheduled( 0 ), amountScheduled( 0 ), amountBackground( 0 ), 
+					tasksWithDeadline( 0 ), missedDeadlines( 0 ), worstLateness( 0 ), amountSleeping( 0 ), 
+					wakeUpCount( 0 ), isStopping( false )
+			{
+				if( amountOfWorkers == 0 )
+					amountOfWorkers = 1;
+				workerNodes.assign( amountOfWorkers, 0 );
+				Start( 1 );
+			}
+			WorkerPool::WorkerPool( const NumaTopology& topology_ ) : topology( topology_ ), 
+					pinsWorkers( topology_.GetAmountOfNodes() > 1 ), amountEverScheduled( 0 ), amountScheduled( 0 ), 
+					amountBackground( 0 ), tasksWithDeadline( 0 ), missedDeadlines( 0 ), worstLateness( 0 ), 
+					amountSleeping( 0 ), wakeUpCount( 0 ), isStopping( false )
+			{
+				const unsigned int AMOUNT_OF_NODES = topology.GetAmountOfNodes();
+				if( AMOUNT_OF_NODES <= 1 )
+				{
+					/*The CPUs sysfs lists can be more than this process is allowed to run on, 
+					so a single node sizes the pool the same way the flat constructor does.*/
+					const unsigned int AMOUNT_OF_WORKERS = std::thread::hardware_concurrency();
+					workerNodes.assign( ( AMOUNT_OF_WORKERS == 0 ) ? 1 : AMOUNT_OF_WORKERS, 0 );
+					Start( 1 );
+					return;
+				}
+				//Memory only nodes get no workers, their queue is drained from the other nodes.//
+				for( unsigned int node = 0; node < AMOUNT_OF_NODES; ++node )
+					workerNodes.insert( workerNodes.end(), topology.GetCpus( node ).size(), node );
+				if( workerNodes.empty() == true )
+					workerNodes.push_back( 0 );
+				Start( AMOUNT_OF_NODES );
+			}
+			void WorkerPool::Start( unsigned int amountOfNodes )
+			{
+				const unsigned int AMOUNT_OF_WORKERS = workerNodes.size();
+				nodeWorkers.resize( amountOfNodes );
+				for( unsigned int i = 0; i < amountOfNodes; ++i )
+					injectionQueues.push_back( std::unique_ptr< InjectionQueue >( new InjectionQueue() ) );
+				for( unsigned int i = 0; i < AMOUNT_OF_WORKERS; ++i )
+					nodeWorkers[ workerNodes[ i ] ].push_back( i );
+				//Every deque has to exist before any worker can try to steal from it.//
+				for( unsigned int i = 0; i < AMOUNT_OF_WORKERS; ++i )
+					deques.push_back( std::unique_ptr< WorkStealingDeque< PoolTask* > >( 
+							new WorkStealingDeque< PoolTask* >() ) );
+				for( unsigned int i = 0; i < AMOUNT_OF_WORKERS; ++i )
+					workers.push_back( std::thread( &WorkerPool::Work, this, i ) );
+			}
+			WorkerPool::~WorkerPool()
+			{
+				{
+					std::lock_guard< std::mutex > lock( sleepGuard );
+					isStopping.store( true, std::memory_order_seq_cst );
+					++wakeUpCount;
+				}
+				wakeUp.notify_all();
+				const unsigned int AMOUNT_OF_WORKERS = workers.size();
+				for( unsigned int i = 0; i < AMOUNT_OF_WORKERS; ++i )
+					workers[ i ].join();
+			}
+			void WorkerPool::InjectionQueue::Push( PoolTask* task )
+			{
+				const std::size_t QUEUED = amount.load( std::memory_order_relaxed );
+				const std::size_t CAPACITY = tasks.size();
+				if( QUEUED == CAPACITY )
+				{
+					std::vector< PoolTask* > grown( CAPACITY * 2 );
+					for( std::size_t i = 0; i < QUEUED; ++i )
+						grown[ i ] = tasks[ ( first + i ) % CAPACITY ];
+					tasks.swap( grown );
+					first = 0;
+				}
+				tasks[ ( first + QUEUED ) % tasks.size() ] = task;
+				amount.fetch_add( 1, std::memory_order_relaxed );
+			}
+			PoolTask* WorkerPool::InjectionQueue::Pop()
+			{
+				if( amount.load( std::memory_order_relaxed ) == 0 )
+					return ( nullptr );
+				PoolTask* task = tasks[ first ];
+				first = ( first + 1 ) % tasks.size();
+				amount.fetch_sub( 1, std::memory_order_relaxed );
+				return task;
+			}
+			void WorkerPool::Submit( PoolTask* task )
+			{
+				if( currentPool == this )
+					deques[ currentWorker ]->Push( task );
+				else
+				{
+					InjectionQueue& queue = *injectionQueues[ CurrentNode() ];
+					std::lock_guard< std::mutex > lock( queue.guard );
+					queue.Push( task );
+				}
+				WakeWorker();
+			}
+			void WorkerPool::Submit( PoolTask* task, THREAD_PRIORITY priority, 
+					std::chrono::steady_clock::time_point deadline )
+			{
+				const bool HAS_DEADLINE = ( deadline != std::chrono::steady_clock::time_point::max() );
+				if( priority == NORMAL_PRIORITY && HAS_DEADLINE == false ) {
+					Submit( task );
+					return;
+				}
+				ScheduledTask entry;
+				entry.task = task;
+				entry.priority = priority;
+				entry.deadline = ( HAS_DEADLINE == true ) ? std::chrono::duration_cast< std::chrono::nanoseconds >( 
+						deadline.time_since_epoch() ).count() : NO_DEADLINE;
+				if( priority == BACKGROUND_PRIORITY )
+				{
+					std::lock_guard< std::mutex > lock( backgroundGuard );
+					entry.sequence = 0;
+					background.push_back( entry );
+					amountBackground.fetch_add( 1, std::memory_order_relaxed );
+				}
+				else
+				{
+					std::lock_guard< std::mutex > lock( scheduledGuard );
+					entry.sequence = amountEverScheduled++;
+					scheduled.push_back( entry );
+					std::push_heap( scheduled.begin(), scheduled.end() );
+					amountScheduled.fetch_add( 1, std::memory_order_relaxed );
+				}
+				WakeWorker();
+			}
+			void WorkerPool::SubmitBatch( PoolTask* const* tasks, std::size_t amount )
+			{
+				if( amount == 0 )
+					return;
+				if( currentPool == this )
+				{
+					WorkStealingDeque< PoolTask* >& deque = *deques[ currentWorker ];
+					for( std::size_t i = 0; i < amount; ++i )
+						deque.Push( tasks[ i ] );
+				}
+				else
+				{
+					InjectionQueue& queue = *injectionQueues[ CurrentNode() ];
+					std::lock_guard< std::mutex > lock( queue.guard );
+					for( std::size_t i = 0; i < amount; ++i )
+						queue.Push( tasks[ i ] );
+				}
+				if( amount == 1 )
+					WakeWorker();
+				else
+					WakeAllWorkers();
+			}
+			void WorkerPool::SubmitFunction( std::function< void() > function )
+			{
+				FunctionTask* task = new FunctionTask();
+				task->function = function;
+				Submit( task );
+			}
+			bool WorkerPool::RunPendingTask()
+			{
+				if( currentPool != this )
+					return ( false );
+				std::int64_t deadline = NO_DEADLINE;
+				PoolTask* task = FindTask( currentWorker, deadline );
+				if( task == nullptr )
+					return ( false );
+				RunTask( task, deadline );
+				return ( true );
+			}
+			bool WorkerPool::IsWorkerThread() {
+				return ( currentPool == this );
+			}
+			DeadlineStats WorkerPool::GetDeadlineStats()
+			{
+				DeadlineStats stats;
+				stats.tasksWithDeadline = tasksWithDeadline.load( std::memory_order_relaxed );
+				stats.missedDeadlines = missedDeadlines.load( std::memory_order_relaxed );
+				stats.worstLateness = std::chrono::nanoseconds( worstLateness.load( std::memory_order_relaxed ) );
+				return stats;
+			}
+			WorkerPool& WorkerPool::Global()
+			{
+				static WorkerPool global( NumaTopology::System() );
+				return global;
+			}
+			unsigned int WorkerPool::CurrentNode()
+			{
+				if( currentPool == this )
+					return ( workerNodes[ currentWorker ] );
+				const unsigned int AMOUNT_OF_NODES = injectionQueues.size();
+				if( AMOUNT_OF_NODES == 1 )
+					return ( 0 );
+				return ( topology.CurrentNode() % AMOUNT_OF_NODES );
+			}
+			PoolTask* WorkerPool::StealFrom( const std::vector< unsigned int >& victims, unsigned int workerIndex )
+			{
+				PoolTask* task = nullptr;
+				const unsigned int AMOUNT_OF_VICTIMS = victims.size();
+				if( AMOUNT_OF_VICTIMS == 0 )
+					return ( nullptr );
+				const unsigned int FIRST_VICTIM = NextVictim() % AMOUNT_OF_VICTIMS;
+				for( unsigned int i = 0; i < AMOUNT_OF_VICTIMS; ++i )
+				{
+					const unsigned int VICTIM = victims[ ( FIRST_VICTIM + i ) % AMOUNT_OF_VICTIMS ];
+					if( VICTIM != workerIndex && deques[ VICTIM ]->Steal( task ) == true )
+						return task;
+				}
+				return ( nullptr );
+			}
+			PoolTask* WorkerPool::TakeInjected( InjectionQueue& queue )
+			{
+				if( queue.amount.load( std::memory_order_relaxed ) == 0 )
+					return ( nullptr );
+				std::lock_guard< std::mutex > lock( queue.guard );
+				return queue.Pop();
+			}
+			PoolTask* WorkerPool::TakeScheduled( std::int64_t& deadline )
+			{
+				if( amountScheduled.load( std::memory_order_relaxed ) == 0 )
+					return ( nullptr );
+				std::lock_guard< std::mutex > lock( scheduledGuard );
+				if( scheduled.empty() == true )
+					return ( nullptr );
+				std::pop_heap( scheduled.begin(), scheduled.end() );
+				const ScheduledTask& MOST_URGENT = scheduled.back();
+				PoolTask* task = MOST_URGENT.task;
+				deadline = MOST_URGENT.deadline;
+				scheduled.pop_back();
+				amountScheduled.fetch_sub( 1, std::memory_order_relaxed );
+				return task;
+			}
+			PoolTask* WorkerPool::TakeBackground( std::int64_t& deadline )
+			{
+				if( amountBackground.load( std::memory_order_relaxed ) == 0 )
+					return ( nullptr );
+				std::lock_guard< std::mutex > lock( backgroundGuard );
+				if( background.empty() == true )
+					return ( nullptr );
+				PoolTask* task = background.front().task;
+				deadline = background.front().deadline;
+				background.pop_front();
+				amountBackground.fetch_sub( 1, std::memory_order_relaxed );
+				return task;
+			}
+			PoolTask* WorkerPool::FindTask( unsigned int workerIndex, std::int64_t& deadline )
+			{
+				PoolTask* task = nullptr;
+				deadline = NO_DEADLINE;
+				if( ( task = TakeScheduled( deadline ) ) != nullptr )
+					return task;
+				if( deques[ workerIndex ]->Pop( task ) == true )
+					return task;
+				//Stay on this node for as long as it has work, its memory is the close memory.//
+				const unsigned int NODE = workerNodes[ workerIndex ];
+				if( ( task = StealFrom( nodeWorkers[ NODE ], workerIndex ) ) != nullptr )
+					return task;
+				if( ( task = TakeInjected( *injectionQueues[ NODE ] ) ) != nullptr )
+					return task;
+				const unsigned int AMOUNT_OF_NODES = nodeWorkers.size();
+				for( unsigned int i = 1; i < AMOUNT_OF_NODES; ++i )
+				{
+					const unsigned int OTHER_NODE = ( NODE + i ) % AMOUNT_OF_NODES;
+					if( ( task = StealFrom( nodeWorkers[ OTHER_NODE ], workerIndex ) ) != nullptr )
+						return task;
+					if( ( task = TakeInjected( *injectionQueues[ OTHER_NODE ] ) ) != nullptr )
+						return task;
+				}
+				return TakeBackground( deadline );
+			}
+			void WorkerPool::RunTask( PoolTask* task, std::int64_t deadline )
+			{
+				task->RunOnWorker();
+				if( deadline == NO_DEADLINE )
+					return;
+				//"task" may be gone by now, only the copy of its deadline is left.//
+				const std::int64_t LATENESS = std::chrono::duration_cast< std::chrono::nanoseconds >( 
+						std::chrono::steady_clock::now().time_since_epoch() ).count() - deadline;
+				tasksWithDeadline.fetch_add( 1, std::memory_order_relaxed );
+				if( LATENESS <= 0 )
+					return;
+				missedDeadlines.fetch_add( 1, std::memory_order_relaxed );
+				std::int64_t worst = worstLateness.load( std::memory_order_relaxed );
+				while( LATENESS > worst && worstLateness.compare_exchange_weak( worst, LATENESS, 
+						std::memory_order_relaxed ) == false );
+			}
+			bool WorkerPool::HasTask()
+			{
+				if( amountScheduled.load( std::memory_order_relaxed ) != 0 || 
+						amountBackground.load( std::memory_order_relaxed ) != 0 )
+					return ( true );
+				const unsigned int AMOUNT_OF_NODES = injectionQueues.size();
+				for( unsigned int i = 0; i < AMOUNT_OF_NODES; ++i )
+					if( injectionQueues[ i ]->amount.load( std::memory_order_relaxed ) != 0 )
+						return ( true );
+				const unsigned int AMOUNT_OF_WORKERS = deques.size();
+				for( unsigned int i = 0; i < AMOUNT_OF_WORKERS; ++i )
+					if( deques[ i ]->IsEmpty() == false )
+						return ( true );
+				return ( false );
+			}
+			void WorkerPool::WakeWorker()
+			{
+				/*Pairs with the fence in Work(), either the sleeper sees the new task or 
+				we see the sleeper.*/
+				std::atomic_thread_fence( std::memory_order_seq_cst );
+				if( amountSleeping.load( std::memory_order_relaxed ) == 0 )
+					return;
+				{
+					std::lock_guard< std::mutex > lock( sleepGuard );
+					++wakeUpCount;
+				}
+				wakeUp.notify_one();
+			}
+			void WorkerPool::WakeAllWorkers()
+			{
+				std::atomic_thread_fence( std::memory_order_seq_cst );
+				if( amountSleeping.load( std::memory_order_relaxed ) == 0 )
+					return;
+				{
+					std::lock_guard< std::mutex > lock( sleepGuard );
+					++wakeUpCount;
+				}
+				wakeUp.notify_all();
+			}
+			void WorkerPool::Work( unsigned int workerIndex )
+			{
+				currentPool = this;
+				currentWorker = workerIndex;
+				stealSeed += workerIndex * 2654435761u;
+				if( pinsWorkers == true )
+				{
+					const std::vector< int >& CPUS = topology.GetCpus( workerNodes[ workerIndex ] );
+					cpu_set_t cpus;
+					CPU_ZERO( &cpus );
+					for( int cpu : CPUS )
+						if( cpu >= 0 && cpu < CPU_SETSIZE )
+							CPU_SET( cpu, &cpus );
+					//Best effort, a cpuset that excludes the node just leaves the worker unpinned.//
+					pthread_setaffinity_np( pthread_self(), sizeof( cpu_set_t ), &cpus );
+				}
+				while( true )
+				{
+					std::int64_t deadline = NO_DEADLINE;
+					PoolTask* task = FindTask( workerIndex, deadline );
+					if( task != nullptr ) {
+						RunTask( task, deadline );
+						continue;
+					}
+					std::unique_lock< std::mutex > lock( sleepGuard );
+					amountSleeping.fetch_add( 1, std::memory_order_relaxed );
+					std::atomic_thread_fence( std::memory_order_seq_cst );
+					//Drain what is left before stopping.//
+					if( HasTask() == true ) {
+						amountSleeping.fetch_sub( 1, std::memory_order_relaxed );
+						continue;
+					}
+					if( isStopping.load( std::memory_order_seq_cst ) == true ) {
+						amountSleeping.fetch_sub( 1, std::memory_order_relaxed );
+						return;
+					}
+					const unsigned long long LAST_WAKE_UP = wakeUpCount;
+					wakeUp.wait( lock, [ & ]() { return ( wakeUpCount != LAST_WAKE_UP ); } );
+					amountSleeping.fetch_sub( 1, std::memory_order_relaxed );
+				}
+			}
+		#endif
+	}
+}
@@ -0,0 +1,179 @@
+/*
+Copyright (C) 2013 Christopher A. Greeley
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), 
+to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, 
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+#pragma once
+#include <chrono>
+#include <ThreadItAtomic.h>
+#include <WorkStealingDeque.h>
+
+namespace LibThreadIt
+{
+	/*How urgently a task should run. HIGH and CRITICAL work, and anything with a 
+	deadline, is taken before the normal queues, earliest deadline first within a 
+	class. BACKGROUND work is only taken when nothing else is waiting.*/
+	enum THREAD_PRIORITY {
+		BACKGROUND_PRIORITY = 0, 
+		NORMAL_PRIORITY = 1, 
+		HIGH_PRIORITY = 2, 
+		CRITICAL_PRIORITY = 3
+	};
+	//How the tasks given a deadline have fared.//
+	struct DeadlineStats
+	{
+		std::uint64_t tasksWithDeadline;
+		//Finished after their deadline.//
+		std::uint64_t missedDeadlines;
+		//How far past its deadline the latest task finished.//
+		std::chrono::nanoseconds worstLateness;
+	};
+	namespace Implementation
+	{
+		#ifdef THREAD_IT_POSIX_PLATFORM
+			//Anything the pool can run, the task is responsible for its own lifetime.//
+			struct PoolTask
+			{
+				virtual void RunOnWorker() = 0;
+				virtual ~PoolTask() {
+				}
+			};
+			/*Work waiting for its turn in a serialized thread tree. Whoever hands the 
+			tree over starts it, no thread waits for the tree on its behalf.*/
+			struct TreeWaiter
+			{
+				virtual void TakeTurn() = 0;
+				virtual ~TreeWaiter() {
+				}
+			};
+			/*Long lived worker threads that run submitted tasks, so launching a task does 
+			not cost a pthread_create and a pthread_join. Each worker owns a deque, tasks 
+			submitted from a worker go on its own deque and idle workers steal from the 
+			other end, only tasks from outside the pool go through the shared queues. 
+			On a NUMA machine there is a group of workers and a shared queue per node, 
+			tasks go to the submitter's node and workers look there before crossing 
+			over to another node.*/
+			class WorkerPool
+			{
+				public: 
+					//One node, workers are not pinned.//
+					explicit WorkerPool( unsigned int amountOfWorkers );
+					/*A worker per CPU of each node, pinned to that node's CPUs. A single node 
+					topology is the same as the constructor above with a worker per CPU.*/
+					explicit WorkerPool( const NumaTopology& topology_ );
+					~WorkerPool();
+					void Submit( PoolTask* task );
+					/*Submits with a priority class and, unless it is time_point::max(), a 
+					deadline the task should finish by.*/
+					void Submit( PoolTask* task, THREAD_PRIORITY priority, 
+							std::chrono::steady_clock::time_point deadline );
+					//Publishes every task at once and wakes the sleeping workers with one broadcast.//
+					void SubmitBatch( PoolTask* const* tasks, std::size_t amount );
+					//For one off work where a heap allocated task does not matter.//
+					void SubmitFunction( std::function< void() > function );
+					/*Runs one pending task on the calling worker, so a worker waiting on 
+					another task keeps the pool moving. 'false' if there was nothing to run 
+					or the caller is not one of our workers.*/
+					bool RunPendingTask();
+					bool IsWorkerThread();
+					unsigned int GetAmountOfWorkers() {
+						return workers.size();
+					}
+					unsigned int GetAmountOfNodes() {
+						return injectionQueues.size();
+					}
+					unsigned int GetNodeOfWorker( unsigned int workerIndex ) {
+						return workerNodes[ workerIndex ];
+					}
+					//The calling worker's node, or for other threads the node of the CPU they are on.//
+					unsigned int CurrentNode();
+					DeadlineStats GetDeadlineStats();
+					//The pool shared by every pooled launch, one worker per hardware thread.//
+					static WorkerPool& Global();
+				protected: 
+					/*A ring that only ever grows, so once it is big enough tasks from other 
+					threads are queued without allocating. Only touched under "guard".*/
+					struct InjectionQueue
+					{
+						std::mutex guard;
+						std::vector< PoolTask* > tasks;
+						//Where the oldest task is in "tasks".//
+						std::size_t first;
+						//How many are queued, read without the lock to skip empty queues.//
+						std::atomic< unsigned int > amount;
+						explicit InjectionQueue() : tasks( 64 ), first( 0 ), amount( 0 ) {
+						}
+						void Push( PoolTask* task );
+						//Null if it is empty.//
+						PoolTask* Pop();
+					};
+					//A task that did not go through the normal queues.//
+					struct ScheduledTask
+					{
+						PoolTask* task;
+						THREAD_PRIORITY priority;
+						//Nanoseconds on the steady clock, NO_DEADLINE if there is none.//
+						std::int64_t deadline;
+						//Keeps tasks of the same priority and deadline first in, first out.//
+						std::uint64_t sequence;
+						//The heap keeps its "largest" entry on top, that is the most urgent one.//
+						bool operator<( const ScheduledTask& other ) const
+						{
+							if( priority != other.priority )
+								return ( priority < other.priority );
+							if( deadline != other.deadline )
+								return ( deadline > other.deadline );
+							return ( sequence > other.sequence );
+						}
+					};
+					static const std::int64_t NO_DEADLINE = INT64_MAX;
+					void Start( unsigned int amountOfNodes );
+					void Work( unsigned int workerIndex );
+					PoolTask* StealFrom( const std::vector< unsigned int >& victims, unsigned int workerIndex );
+					PoolTask* TakeInjected( InjectionQueue& queue );
+					PoolTask* TakeScheduled( std::int64_t& deadline );
+					PoolTask* TakeBackground( std::int64_t& deadline );
+					PoolTask* FindTask( unsigned int workerIndex, std::int64_t& deadline );
+					//Runs "task" and, if it had one, checks whether it made its deadline.//
+					void RunTask( PoolTask* task, std::int64_t deadline );
+					bool HasTask();
+					void WakeWorker();
+					void WakeAllWorkers();
+					std::vector< std::thread > workers;
+					std::vector< std::unique_ptr< WorkStealingDeque< PoolTask* > > > deques;
+					NumaTopology topology;
+					bool pinsWorkers;
+					std::vector< unsigned int > workerNodes;
+					//The workers of each node.//
+					std::vector< std::vector< unsigned int > > nodeWorkers;
+					//Tasks submitted by threads that are not workers, one queue per node.//
+					std::vector< std::unique_ptr< InjectionQueue > > injectionQueues;
+					//HIGH and CRITICAL tasks and tasks with a deadline, as a heap.//
+					std::mutex scheduledGuard;
+					std::vector< ScheduledTask > scheduled;
+					std::uint64_t amountEverScheduled;
+					std::atomic< unsigned int > amountScheduled;
+					std::mutex backgroundGuard;
+					std::deque< ScheduledTask > background;
+					std::atomic< unsigned int > amountBackground;
+					std::atomic< std::uint64_t > tasksWithDeadline;
+					std::atomic< std::uint64_t > missedDeadlines;
+					std::atomic< std::int64_t > worstLateness;
+					//Workers with nothing to do sleep here.//
+					std::mutex sleepGuard;
+					std::condition_variable wakeUp;
+					std::atomic< unsigned int > amountSleeping;
+					unsigned long long wakeUpCount;
+					std::atomic< bool > isStopping;
+			};
+		#endif
+	}
+}